@@ -3,6 +3,7 @@ LOCAL_PATH := $(call my-dir)
 include $(CLEAR_VARS)
 
 LOCAL_CFLAGS := -std=gnu++11
+LOCAL_CFLAGS += -D_FILE_OFFSET_BITS=64 -DBTSNOOP_ZLIB
 LOCAL_CFLAGS += -funwind-tables -Wl,--no-merge-exidx-entries
 LOCAL_CPPFLAGS += -fexceptions
 
@@ -13,9 +14,28 @@ LOCAL_C_INCLUDES += $(LOCAL_PATH)/include
 
 LOCAL_SRC_FILES := src/btsnoopfileinfo.cpp \
 	src/btsnooppacket.cpp \
+	src/btsnooppayload.cpp \
+	src/btsnooparena.cpp \
+	src/btsnooprecordrange.cpp \
+	src/btsnoopcolumnstore.cpp \
+	src/btsnooppackedstore.cpp \
+	src/btsnoopindexfile.cpp \
+	src/btsnoopoffsetindex.cpp \
+	src/btsnooptimeindex.cpp \
+	src/btsnooppacketreader.cpp \
+	src/btsnoopheaderdecoder.cpp \
+	src/btsnooppacketview.cpp \
+	src/btsnooptimestamp.cpp \
+	src/btsnoopmappedfile.cpp \
+	src/btsnoopfilewatcher.cpp \
+	src/btsnoopblockreader.cpp \
+	src/btsnoopuringreader.cpp \
+	src/btsnoopdecompresssource.cpp \
+	src/btsnoopstreamsource.cpp \
+	src/btsnooplisteneradapter.cpp \
 	src/btsnoopparser.cpp \
 	src/btsnooptask.cpp
 
-LOCAL_LDLIBS := -llog
+LOCAL_LDLIBS := -llog -lz
 
 include $(BUILD_SHARED_LIBRARY)
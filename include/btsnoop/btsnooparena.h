@@ -0,0 +1,134 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooparena.h
+
+	Bump allocator for packet payloads : memory is taken from large slabs and
+	released all at once
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPARENA_H
+#define BTSNOOPARENA_H
+
+#include "vector"
+#include <stddef.h>
+
+//size of one slab (bigger payloads get their own slab)
+#define ARENA_SLAB_SIZE (1024 * 1024)
+
+class BtSnoopArena
+{
+
+public:
+
+	/**
+	 * @brief
+	 *      build empty arena
+	 * @param slab_size
+	 *      size of one slab
+	 */
+	BtSnoopArena(size_t slab_size = ARENA_SLAB_SIZE);
+
+	/**
+	 * @brief
+	 *      memory is not copied : copy is an empty arena
+	 */
+	BtSnoopArena(const BtSnoopArena&);
+
+	BtSnoopArena& operator=(const BtSnoopArena&);
+
+	~BtSnoopArena();
+
+	/**
+	 * @brief
+	 *      allocate memory valid until clear() / arena destruction
+	 * @param size
+	 *      number of bytes
+	 * @return
+	 *      allocated memory
+	 */
+	char * allocate(size_t size);
+
+	/**
+	 * @brief
+	 *      copy data into arena
+	 * @param data
+	 *      data to copy
+	 * @param size
+	 *      number of bytes
+	 * @return
+	 *      copy of data
+	 */
+	const char * copy(const char * data,size_t size);
+
+	/**
+	 * @brief
+	 *      release all slabs (memory allocated previously is no longer valid)
+	 */
+	void clear();
+
+	/**
+	 * @brief
+	 *      get number of bytes allocated since last clear()
+	 * @return
+	 */
+	size_t used() const;
+
+private:
+
+	/**
+	 * @brief
+	 *      size of one slab
+	 */
+	size_t slab_size;
+
+	/**
+	 * @brief
+	 *      allocated slabs
+	 */
+	std::vector<char*> slabs;
+
+	/**
+	 * @brief
+	 *      next free byte in current slab
+	 */
+	char * current;
+
+	/**
+	 * @brief
+	 *      number of free bytes in current slab
+	 */
+	size_t remaining;
+
+	/**
+	 * @brief
+	 *      number of bytes allocated since last clear()
+	 */
+	size_t used_size;
+};
+
+#endif // BTSNOOPARENA_H
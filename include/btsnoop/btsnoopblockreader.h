@@ -0,0 +1,194 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopblockreader.h
+
+	Read btsnoop file by large blocks, records are parsed in place
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPBLOCKREADER_H
+#define BTSNOOPBLOCKREADER_H
+
+#include "vector"
+#include "btsnoop/btsnoopuringreader.h"
+#include "btsnoop/ibtsnoopsource.h"
+#include <stddef.h>
+#include <inttypes.h>
+
+//default size of one read (records straddling two blocks are moved to the front of the buffer)
+#define BLOCK_READER_DEFAULT_SIZE (1024 * 1024)
+
+class BtSnoopBlockReader
+{
+
+public:
+
+	/**
+	 * @brief
+	 *      build block reader
+	 * @param block_size
+	 *      size of one read
+	 */
+	BtSnoopBlockReader(size_t block_size = BLOCK_READER_DEFAULT_SIZE);
+
+	/**
+	 * @brief
+	 *      start reading a file descriptor at a given position (buffered data is dropped)
+	 * @param fd
+	 *      file descriptor (read with pread, file offset is not used)
+	 * @param position
+	 *      position of first byte to read
+	 * @param end
+	 *      position where reading stops (-1 to read until end of file)
+	 * @param async
+	 *      keep several reads in flight with io_uring (plain pread if not available)
+	 */
+	void reset(int fd,int64_t position,int64_t end = -1,bool async = false);
+
+	/**
+	 * @brief
+	 *      continue reading a file descriptor after buffered data (file has grown). Bytes
+	 *      of an incomplete record read previously are kept and are not read again
+	 * @param fd
+	 *      file descriptor
+	 * @param position
+	 *      expected position of first byte not consumed yet
+	 * @param end
+	 *      position where reading stops (-1 to read until end of file)
+	 * @return
+	 *      false if reader is not positioned on this descriptor / position (reset() must be used)
+	 */
+	bool resume(int fd,int64_t position,int64_t end = -1);
+
+	/**
+	 * @brief
+	 *      start reading a sequential source (buffered data is dropped), position
+	 *      is the number of bytes read from source
+	 * @param source
+	 *      byte source
+	 */
+	void reset(IBtSnoopSource * source);
+
+	/**
+	 * @brief
+	 *      read next block after buffered data. Data not consumed yet is moved to the
+	 *      front of the buffer so that a record straddling two blocks is contiguous
+	 * @param min_available
+	 *      buffer is grown if needed so that this number of bytes can be buffered
+	 *      (record bigger than block size)
+	 * @return
+	 *      number of bytes read (0 on end of file / error)
+	 */
+	size_t fill(size_t min_available = 0);
+
+	/**
+	 * @brief
+	 *      get first buffered byte not consumed yet
+	 * @return
+	 */
+	const char * data() const;
+
+	/**
+	 * @brief
+	 *      get number of buffered bytes not consumed yet
+	 * @return
+	 */
+	size_t available() const;
+
+	/**
+	 * @brief
+	 *      mark bytes as consumed
+	 * @param size
+	 *      number of bytes (must be <= available())
+	 */
+	void consume(size_t size);
+
+	/**
+	 * @brief
+	 *      get file position of data()
+	 * @return
+	 */
+	int64_t position() const;
+
+private:
+
+	/**
+	 * @brief
+	 *      file descriptor being read
+	 */
+	int fd;
+
+	/**
+	 * @brief
+	 *      sequential source being read (0 when reading file descriptor)
+	 */
+	IBtSnoopSource * source;
+
+	/**
+	 * @brief
+	 *      size of one read
+	 */
+	size_t block_size;
+
+	/**
+	 * @brief
+	 *      file position of next read
+	 */
+	int64_t read_position;
+
+	/**
+	 * @brief
+	 *      position where reading stops (-1 for end of file)
+	 */
+	int64_t end_position;
+
+	/**
+	 * @brief
+	 *      asynchronous reader used instead of pread when opened
+	 */
+	BtSnoopUringReader uring_reader;
+
+	/**
+	 * @brief
+	 *      read buffer
+	 */
+	std::vector<char> buffer;
+
+	/**
+	 * @brief
+	 *      index of first byte not consumed in buffer
+	 */
+	size_t begin;
+
+	/**
+	 * @brief
+	 *      index after last buffered byte
+	 */
+	size_t end;
+};
+
+#endif // BTSNOOPBLOCKREADER_H
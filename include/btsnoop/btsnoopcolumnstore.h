@@ -0,0 +1,205 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopcolumnstore.h
+
+	Columnar packet record store : one contiguous array per header field and all
+	payloads in a single byte heap
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPCOLUMNSTORE_H
+#define BTSNOOPCOLUMNSTORE_H
+
+#include "vector"
+#include "btsnoop/btsnooppacketview.h"
+#include "btsnoop/btsnoopdataspan.h"
+#include <stddef.h>
+#include <inttypes.h>
+
+//packet flags column bits (same as btsnoop record flags)
+#define COLUMN_FLAG_RECEIVED      0x01
+#define COLUMN_FLAG_COMMAND_EVENT 0x02
+
+//maximum number of records decoded per batch by append(data,size)
+#define COLUMN_BATCH_SIZE 4096
+
+class BtSnoopColumnStore
+{
+
+public:
+
+	BtSnoopColumnStore();
+
+	/**
+	 * @brief
+	 *      append a packet record (header fields and payload are copied)
+	 * @param record
+	 *      packet record view
+	 */
+	void append(const BtSnoopPacketView &record);
+
+	/**
+	 * @brief
+	 *      append all complete packet records at the beginning of a buffer (headers
+	 *      are decoded by batch)
+	 * @param data
+	 *      buffer starting with a packet record
+	 * @param size
+	 *      buffer size
+	 * @return
+	 *      number of bytes used by appended records
+	 */
+	size_t append(const char * data,size_t size);
+
+	/**
+	 * @brief
+	 *      remove oldest records (columns are shifted : remove by batch)
+	 * @param count
+	 *      number of records (<= size())
+	 */
+	void pop_front(size_t count);
+
+	/**
+	 * @brief
+	 *      remove all records
+	 */
+	void clear();
+
+	/**
+	 * @brief
+	 *      reserve memory for a number of records
+	 * @param count
+	 *      number of records
+	 * @param payload_size
+	 *      total payload size
+	 */
+	void reserve(size_t count,size_t payload_size);
+
+	/**
+	 * @brief
+	 *      get number of records
+	 * @return
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief
+	 *      get btsnoop timestamps column (microseconds since 01/01/0 AD)
+	 * @return
+	 */
+	const uint64_t * getTimestamps() const;
+
+	/**
+	 * @brief
+	 *      get original lengths column
+	 * @return
+	 */
+	const uint32_t * getOriginalLengths() const;
+
+	/**
+	 * @brief
+	 *      get included lengths column
+	 * @return
+	 */
+	const uint32_t * getIncludedLengths() const;
+
+	/**
+	 * @brief
+	 *      get cumulative drops column
+	 * @return
+	 */
+	const uint32_t * getCumulativeDrops() const;
+
+	/**
+	 * @brief
+	 *      get packet flags column (COLUMN_FLAG_RECEIVED / COLUMN_FLAG_COMMAND_EVENT bits)
+	 * @return
+	 */
+	const uint8_t * getFlags() const;
+
+	/**
+	 * @brief
+	 *      get payload offsets in payload heap (size() + 1 values, payload i is
+	 *      [offset i, offset i + 1[)
+	 * @return
+	 */
+	const uint64_t * getPayloadOffsets() const;
+
+	/**
+	 * @brief
+	 *      get payload heap (all payloads one after the other)
+	 * @return
+	 */
+	const char * getPayloadHeap() const;
+
+	/**
+	 * @brief
+	 *      get payload of a record without copy (valid until next append / clear)
+	 * @param index
+	 *      record index
+	 * @return
+	 */
+	BtSnoopDataSpan getPayload(size_t index) const;
+
+private:
+
+	std::vector<uint64_t> timestamps;
+
+	std::vector<uint32_t> original_lengths;
+
+	std::vector<uint32_t> included_lengths;
+
+	std::vector<uint32_t> cumulative_drops;
+
+	std::vector<uint8_t> flags;
+
+	std::vector<uint64_t> payload_offsets;
+
+	std::vector<char> payload_heap;
+
+	/**
+	 * @brief
+	 *      record offsets in appended buffer (kept between two append)
+	 */
+	std::vector<size_t> offsets;
+
+	/**
+	 * @brief
+	 *      append at most max_count complete packet records at the beginning of a buffer
+	 * @param data
+	 *      buffer starting with a packet record
+	 * @param size
+	 *      buffer size
+	 * @param max_count
+	 *      maximum number of records
+	 * @return
+	 *      number of bytes used by appended records
+	 */
+	size_t append_batch(const char * data,size_t size,size_t max_count);
+};
+
+#endif // BTSNOOPCOLUMNSTORE_H
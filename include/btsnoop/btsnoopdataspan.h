@@ -0,0 +1,95 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopdataspan.h
+
+	Non-owning contiguous byte range (pointer + size)
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPDATASPAN_H
+#define BTSNOOPDATASPAN_H
+
+#include <stddef.h>
+
+class BtSnoopDataSpan
+{
+
+public:
+
+	/**
+	 * @brief
+	 *      build a span over size bytes starting at data
+	 * @param data
+	 *      first byte
+	 * @param size
+	 *      number of bytes
+	 */
+	BtSnoopDataSpan(const char * data = 0,size_t size = 0) : ptr(data), length(size) {}
+
+	/**
+	 * @brief
+	 *      get first byte
+	 * @return
+	 */
+	const char * data() const { return ptr; }
+
+	/**
+	 * @brief
+	 *      get number of bytes
+	 * @return
+	 */
+	size_t size() const { return length; }
+
+	/**
+	 * @brief
+	 *      define if span is empty
+	 * @return
+	 */
+	bool empty() const { return length == 0; }
+
+	const char * begin() const { return ptr; }
+
+	const char * end() const { return ptr + length; }
+
+	char operator[](size_t index) const { return ptr[index]; }
+
+private:
+
+	/**
+	 * @brief
+	 *      first byte
+	 */
+	const char * ptr;
+
+	/**
+	 * @brief
+	 *      number of bytes
+	 */
+	size_t length;
+};
+
+#endif // BTSNOOPDATASPAN_H
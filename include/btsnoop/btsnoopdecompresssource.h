@@ -0,0 +1,254 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopdecompresssource.h
+
+	Decompress gzip/zstd btsnoop file in a dedicated thread (pipelined with decoding)
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPDECOMPRESSSOURCE_H
+#define BTSNOOPDECOMPRESSSOURCE_H
+
+#include "vector"
+#include "deque"
+#include "pthread.h"
+#include <inttypes.h>
+#include "btsnoop/ibtsnoopsource.h"
+#include "btsnoop/btsnoopcompression.h"
+
+//size of one decompressed chunk
+#define DECOMPRESS_CHUNK_SIZE (1024 * 1024)
+
+//number of decompressed chunks waiting to be decoded
+#define DECOMPRESS_QUEUE_DEPTH 4
+
+class BtSnoopDecompressSource : public IBtSnoopSource
+{
+
+public:
+
+	BtSnoopDecompressSource();
+
+	/**
+	 * @brief
+	 *      stop and join decompression thread
+	 */
+	~BtSnoopDecompressSource();
+
+	/**
+	 * @brief
+	 *      detect compression format from first bytes of file
+	 * @param data
+	 *      first bytes of file
+	 * @param size
+	 *      number of bytes
+	 * @return
+	 *      compression format
+	 */
+	static compression_type detect(const char * data,size_t size);
+
+	/**
+	 * @brief
+	 *      define if a compression format has been built in
+	 * @param type
+	 *      compression format
+	 * @return
+	 */
+	static bool is_supported(compression_type type);
+
+	/**
+	 * @brief
+	 *      start decompressing file in decompression thread
+	 * @param fd
+	 *      compressed file descriptor (read with pread from the beginning)
+	 * @param type
+	 *      compression format
+	 * @return
+	 *      success status (false if format is not supported)
+	 */
+	bool open(int fd,compression_type type);
+
+	/**
+	 * @brief
+	 *      stop and join decompression thread
+	 */
+	void close();
+
+	/**
+	 * @brief
+	 *      read next decompressed bytes (blocking until decompression thread provides some)
+	 * @param data
+	 *      destination buffer
+	 * @param size
+	 *      maximum number of bytes to read
+	 * @return
+	 *      number of bytes read, 0 on end of data, -1 on decompression error
+	 */
+	ssize_t read(char * data,size_t size);
+
+	/**
+	 * @brief
+	 *      define if decompression failed (corrupted or truncated file). Final once read()
+	 *      has returned 0 or -1
+	 * @return
+	 */
+	bool has_failed();
+
+	static void *decompress_helper(void *context) {
+		return ((BtSnoopDecompressSource *)context)->decompress_task();
+	}
+
+private:
+
+	BtSnoopDecompressSource(const BtSnoopDecompressSource&);
+
+	BtSnoopDecompressSource& operator=(const BtSnoopDecompressSource&);
+
+	/**
+	 * @brief
+	 *      decompression thread task
+	 */
+	void * decompress_task(void);
+
+	/**
+	 * @brief
+	 *      decompress gzip file (one or more gzip members)
+	 * @return
+	 *      success status
+	 */
+	bool inflate_gzip();
+
+	/**
+	 * @brief
+	 *      decompress zstd file (one or more zstd frames)
+	 * @return
+	 *      success status
+	 */
+	bool inflate_zstd();
+
+	/**
+	 * @brief
+	 *      read next compressed bytes
+	 * @param data
+	 *      destination buffer
+	 * @param size
+	 *      maximum number of bytes to read
+	 * @return
+	 *      number of bytes read, 0 on end of file, -1 on error
+	 */
+	ssize_t read_input(char * data,size_t size);
+
+	/**
+	 * @brief
+	 *      give a decompressed chunk to reader (wait if queue is full)
+	 * @param chunk
+	 *      decompressed data (swapped with a recycled chunk)
+	 * @return
+	 *      false if source is being closed
+	 */
+	bool push_chunk(std::vector<char> &chunk);
+
+	/**
+	 * @brief
+	 *      compressed file descriptor
+	 */
+	int fd;
+
+	/**
+	 * @brief
+	 *      position of next compressed read
+	 */
+	int64_t input_position;
+
+	/**
+	 * @brief
+	 *      compression format
+	 */
+	compression_type type;
+
+	/**
+	 * @brief
+	 *      decompression thread
+	 */
+	pthread_t decompress_thread;
+
+	/**
+	 * @brief
+	 *      define if decompression thread is running
+	 */
+	bool thread_started;
+
+	/**
+	 * @brief
+	 *      protect chunk queue and states
+	 */
+	pthread_mutex_t lock;
+
+	/**
+	 * @brief
+	 *      signaled when a chunk is pushed / consumed or state changes
+	 */
+	pthread_cond_t cond;
+
+	/**
+	 * @brief
+	 *      decompressed chunks waiting to be read
+	 */
+	std::deque<std::vector<char> > chunks;
+
+	/**
+	 * @brief
+	 *      chunks already read, reused by decompression thread
+	 */
+	std::vector<std::vector<char> > free_chunks;
+
+	/**
+	 * @brief
+	 *      bytes already read in first chunk
+	 */
+	size_t chunk_offset;
+
+	/**
+	 * @brief
+	 *      decompression thread has ended (end of file)
+	 */
+	bool finished;
+
+	/**
+	 * @brief
+	 *      decompression thread has ended with an error
+	 */
+	bool failed;
+
+	/**
+	 * @brief
+	 *      reader is closing : decompression thread must exit
+	 */
+	bool stopped;
+};
+
+#endif // BTSNOOPDECOMPRESSSOURCE_H
@@ -0,0 +1,110 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopendian.h
+
+	Big endian field loads used by btsnoop header decoding (single load + byte swap)
+	and stores used to rebuild record headers
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPENDIAN_H
+#define BTSNOOPENDIAN_H
+
+#include <string.h>
+#include <inttypes.h>
+
+/**
+ * @brief
+ *      read big endian 32 bit value
+ * @param data
+ *      first byte (no alignment required)
+ * @return
+ */
+static inline uint32_t btsnoop_read_be32(const char * data){
+
+	#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	uint32_t value;
+	memcpy(&value, data, 4);
+	return __builtin_bswap32(value);
+	#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	uint32_t value;
+	memcpy(&value, data, 4);
+	return value;
+	#else
+	return ((uint32_t)(data[0] & 0xFF) << 24) | ((uint32_t)(data[1] & 0xFF) << 16) | ((uint32_t)(data[2] & 0xFF) << 8) | (uint32_t)(data[3] & 0xFF);
+	#endif
+}
+
+/**
+ * @brief
+ *      read big endian 64 bit value
+ * @param data
+ *      first byte (no alignment required)
+ * @return
+ */
+static inline uint64_t btsnoop_read_be64(const char * data){
+
+	#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	uint64_t value;
+	memcpy(&value, data, 8);
+	return __builtin_bswap64(value);
+	#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	uint64_t value;
+	memcpy(&value, data, 8);
+	return value;
+	#else
+	return ((uint64_t)btsnoop_read_be32(data) << 32) | btsnoop_read_be32(data + 4);
+	#endif
+}
+
+/**
+ * @brief
+ *      write big endian 32 bit value
+ * @param data
+ *      first byte (no alignment required)
+ * @param value
+ */
+static inline void btsnoop_write_be32(char * data,uint32_t value){
+	data[0] = (char)(value >> 24);
+	data[1] = (char)(value >> 16);
+	data[2] = (char)(value >> 8);
+	data[3] = (char)value;
+}
+
+/**
+ * @brief
+ *      write big endian 64 bit value
+ * @param data
+ *      first byte (no alignment required)
+ * @param value
+ */
+static inline void btsnoop_write_be64(char * data,uint64_t value){
+	btsnoop_write_be32(data, (uint32_t)(value >> 32));
+	btsnoop_write_be32(data + 4, (uint32_t)value);
+}
+
+#endif // BTSNOOPENDIAN_H
@@ -48,7 +48,7 @@ public:
 	 * @param data
 	 *      file header data of size 16 (16 octet => 8 + 4 + 4)
 	 */
-	BtSnoopFileInfo(char* data);
+	BtSnoopFileInfo(const char* data);
 
 	BtSnoopFileInfo();
 
@@ -0,0 +1,172 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopfilewatcher.h
+
+	Wait for changes on a streamed btsnoop file (inotify with polling fallback)
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPFILEWATCHER_H
+#define BTSNOOPFILEWATCHER_H
+
+#include "string"
+#include "pthread.h"
+#include <sys/types.h>
+#include <time.h>
+
+enum watch_event{
+
+	WATCH_TIMEOUT  = 0,
+	WATCH_MODIFIED = 1,
+	WATCH_MOVED    = 2,
+	WATCH_DELETED  = 4,
+	WATCH_WAKEUP   = 8
+
+};
+
+class BtSnoopFileWatcher
+{
+
+public:
+
+	BtSnoopFileWatcher();
+
+	/**
+	 * @brief
+	 *      watch state is not copied : copy is a closed watcher
+	 */
+	BtSnoopFileWatcher(const BtSnoopFileWatcher&);
+
+	BtSnoopFileWatcher& operator=(const BtSnoopFileWatcher&);
+
+	~BtSnoopFileWatcher();
+
+	/**
+	 * @brief
+	 *      start watching file (inotify if supported by file system, adaptive polling otherwise)
+	 * @param file_path
+	 *      btsnoop file path
+	 * @return
+	 *      success status
+	 */
+	bool open(std::string file_path);
+
+	/**
+	 * @brief
+	 *      stop watching file
+	 */
+	void close();
+
+	/**
+	 * @brief
+	 *      block until watched file changes or wakeup() is called
+	 * @return
+	 *      mask of watch_event
+	 */
+	int wait();
+
+	/**
+	 * @brief
+	 *      interrupt a pending wait() (may be called from any thread)
+	 */
+	void wakeup();
+
+	/**
+	 * @brief
+	 *      define if file changes are notified by inotify (false when polling)
+	 * @return
+	 */
+	bool is_event_driven();
+
+private:
+
+	/**
+	 * @brief
+	 *      (re)register inotify watch on file path
+	 * @return
+	 *      success status
+	 */
+	bool add_watch();
+
+	/**
+	 * @brief
+	 *      wait with inotify events
+	 */
+	int wait_event();
+
+	/**
+	 * @brief
+	 *      wait with stat polling, interval grows while file is idle
+	 */
+	int wait_polling();
+
+	/**
+	 * @brief
+	 *      btsnoop file path
+	 */
+	std::string file_path;
+
+	/**
+	 * @brief
+	 *      inotify instance (-1 when polling)
+	 */
+	int inotify_fd;
+
+	/**
+	 * @brief
+	 *      inotify watch descriptor on file path (-1 if file is gone)
+	 */
+	int watch_fd;
+
+	/**
+	 * @brief
+	 *      self-pipe used to interrupt wait()
+	 */
+	int wakeup_pipe[2];
+
+	/**
+	 * @brief
+	 *      current polling interval in milliseconds
+	 */
+	int poll_interval;
+
+	/**
+	 * @brief
+	 *      last polled file state
+	 */
+	ino_t last_inode;
+	off_t last_size;
+	struct timespec last_mtime;
+
+	/**
+	 * @brief
+	 *      protect descriptors between wakeup() and close()
+	 */
+	pthread_mutex_t lock;
+};
+
+#endif // BTSNOOPFILEWATCHER_H
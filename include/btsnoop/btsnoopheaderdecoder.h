@@ -0,0 +1,99 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopheaderdecoder.h
+
+	Batch decoding of consecutive packet record headers into columns. SSSE3
+	shuffles are used when supported by the cpu, scalar byte swaps otherwise
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPHEADERDECODER_H
+#define BTSNOOPHEADERDECODER_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+/**
+ * @brief
+ *      output columns of header decoding : columns set to 0 are not written
+ */
+struct BtSnoopHeaderColumns{
+
+	/* offset of record in decoded buffer */
+	size_t * offsets;
+
+	uint32_t * original_lengths;
+
+	uint32_t * included_lengths;
+
+	/* low byte of record flags */
+	uint8_t * flags;
+
+	uint32_t * cumulative_drops;
+
+	/* btsnoop timestamps (microseconds since 01/01/0 AD) */
+	uint64_t * timestamps;
+};
+
+class BtSnoopHeaderDecoder
+{
+
+public:
+
+	/**
+	 * @brief
+	 *      decode headers of complete packet records at the beginning of a buffer
+	 * @param data
+	 *      buffer starting with a packet record
+	 * @param size
+	 *      buffer size
+	 * @param max_count
+	 *      maximum number of records to decode (size of each column)
+	 * @param columns
+	 *      output columns
+	 * @param consumed
+	 *      number of bytes used by decoded records
+	 * @return
+	 *      number of decoded records
+	 */
+	static size_t decode(const char * data,size_t size,size_t max_count,const BtSnoopHeaderColumns &columns,size_t &consumed);
+
+	/**
+	 * @brief
+	 *      same as decode() without SIMD instructions (identical results)
+	 */
+	static size_t decode_scalar(const char * data,size_t size,size_t max_count,const BtSnoopHeaderColumns &columns,size_t &consumed);
+
+	/**
+	 * @brief
+	 *      define if decode() uses SIMD instructions on this cpu
+	 * @return
+	 */
+	static bool is_simd_supported();
+};
+
+#endif // BTSNOOPHEADERDECODER_H
@@ -0,0 +1,268 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopindexfile.h
+
+	Persistent sidecar index of a btsnoop file (<file>.idx) : start offset and
+	timestamp of each packet record. Index is validated against size, modification
+	time and header of the btsnoop file and only records appended since last save
+	are indexed
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPINDEXFILE_H
+#define BTSNOOPINDEXFILE_H
+
+#include "string"
+#include "vector"
+#include "btsnoop/btsnoopmappedfile.h"
+#include "btsnoop/btsnoopoffsetindex.h"
+#include <stddef.h>
+#include <inttypes.h>
+
+//sidecar index file extension
+#define INDEX_FILE_EXTENSION ".idx"
+
+//sidecar index format version
+#define INDEX_FILE_VERSION 1
+
+//size of btsnoop file read at once when indexing appended records
+#define INDEX_READ_SIZE (1024 * 1024)
+
+struct BtSnoopIndexEntry
+{
+	/**
+	 * @brief
+	 *      position of packet record in btsnoop file
+	 */
+	int64_t offset;
+
+	/**
+	 * @brief
+	 *      btsnoop timestamp of packet record (microseconds since 01/01/0 AD)
+	 */
+	uint64_t timestamp;
+};
+
+/**
+ * @brief
+ *      sidecar index header (host byte order : an index written with another byte
+ *      order is rebuilt)
+ */
+struct BtSnoopIndexHeader
+{
+	char magic[8];
+
+	uint32_t version;
+
+	uint32_t entry_size;
+
+	/**
+	 * @brief
+	 *      number of indexed packet records
+	 */
+	uint64_t record_count;
+
+	/**
+	 * @brief
+	 *      position after last indexed packet record
+	 */
+	int64_t indexed_end;
+
+	/**
+	 * @brief
+	 *      btsnoop file size and modification time when index was saved
+	 */
+	int64_t capture_size;
+
+	int64_t capture_mtime_sec;
+
+	int64_t capture_mtime_nsec;
+
+	/**
+	 * @brief
+	 *      btsnoop file header
+	 */
+	char capture_header[16];
+};
+
+class BtSnoopIndexFile
+{
+
+public:
+
+	BtSnoopIndexFile();
+
+	/**
+	 * @brief
+	 *      records are not copied : copy is an empty index (btsnoop file is indexed
+	 *      again from its header)
+	 */
+	BtSnoopIndexFile(const BtSnoopIndexFile&);
+
+	BtSnoopIndexFile& operator=(const BtSnoopIndexFile&);
+
+	/**
+	 * @brief
+	 *      load sidecar index of a btsnoop file (memory mapped). Index not matching
+	 *      btsnoop file (other header, truncated file, last indexed record changed) is
+	 *      discarded
+	 * @param index_path
+	 *      sidecar index path
+	 * @param fd
+	 *      btsnoop file descriptor
+	 * @return
+	 *      true if existing index is used
+	 */
+	bool load(std::string index_path,int fd);
+
+	/**
+	 * @brief
+	 *      discard loaded index : btsnoop file is indexed from its header
+	 */
+	void reset();
+
+	/**
+	 * @brief
+	 *      index packet records appended to btsnoop file since last indexed record
+	 * @param fd
+	 *      btsnoop file descriptor
+	 * @return
+	 *      number of new records
+	 */
+	size_t update(int fd);
+
+	/**
+	 * @brief
+	 *      write index (only new records are written if loaded index was valid)
+	 * @return
+	 *      success status
+	 */
+	bool save();
+
+	/**
+	 * @brief
+	 *      get number of indexed packet records
+	 * @return
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief
+	 *      get position of a packet record in btsnoop file
+	 * @param index
+	 *      record index (< size())
+	 * @return
+	 */
+	int64_t getOffset(size_t index) const;
+
+	/**
+	 * @brief
+	 *      get btsnoop timestamp of a packet record
+	 * @param index
+	 *      record index (< size())
+	 * @return
+	 */
+	uint64_t getTimestamp(size_t index) const;
+
+	/**
+	 * @brief
+	 *      get position after last indexed packet record
+	 * @return
+	 */
+	int64_t getIndexedEnd() const;
+
+private:
+
+	/**
+	 * @brief
+	 *      write records indexed since index was loaded
+	 * @param fd
+	 *      sidecar index file descriptor
+	 * @param position
+	 *      position of first written record in sidecar index
+	 * @return
+	 *      success status
+	 */
+	bool write_entries(int fd,int64_t position) const;
+
+	/**
+	 * @brief
+	 *      check loaded index against btsnoop file
+	 * @param fd
+	 *      btsnoop file descriptor
+	 * @return
+	 *      true if index matches btsnoop file
+	 */
+	bool validate(int fd);
+
+	/**
+	 * @brief
+	 *      sidecar index path
+	 */
+	std::string index_path;
+
+	/**
+	 * @brief
+	 *      mapping of sidecar index
+	 */
+	BtSnoopMappedFile mapping;
+
+	/**
+	 * @brief
+	 *      index header (loaded or rebuilt)
+	 */
+	BtSnoopIndexHeader header;
+
+	/**
+	 * @brief
+	 *      records of loaded index (in mapping)
+	 */
+	const BtSnoopIndexEntry * mapped_entries;
+
+	/**
+	 * @brief
+	 *      number of records of loaded index
+	 */
+	size_t mapped_count;
+
+	/**
+	 * @brief
+	 *      positions / timestamps of records indexed since index was loaded (32 bit
+	 *      deltas by block)
+	 */
+	BtSnoopOffsetIndex offsets;
+
+	BtSnoopOffsetIndex timestamps;
+
+	/**
+	 * @brief
+	 *      btsnoop file was modified since index was saved
+	 */
+	bool modified;
+};
+
+#endif // BTSNOOPINDEXFILE_H
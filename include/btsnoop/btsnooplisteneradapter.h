@@ -0,0 +1,75 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooplisteneradapter.h
+
+	Deliver packet records to a legacy IBtSnoopListener through the record listener interface
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPLISTENERADAPTER_H
+#define BTSNOOPLISTENERADAPTER_H
+
+#include "btsnoop/ibtsnooprecordlistener.h"
+#include "btsnoop/ibtsnooplistener.h"
+
+class BtSnoopListenerAdapter : public IBtSnoopRecordListener
+{
+
+public:
+
+	/**
+	 * @brief
+	 *      build adapter
+	 * @param listener
+	 *      legacy listener (not owned)
+	 */
+	BtSnoopListenerAdapter(IBtSnoopListener * listener);
+
+	#ifdef __ANDROID__
+	void onSnoopPacket(const BtSnoopFileInfo &fileInfo,const BtSnoopPacketView &record,JNIEnv * jni_env);
+
+	void onFinishedCountingPackets(int packet_count,JNIEnv * jni_env);
+
+	void onError(int error_code,const std::string &error_message,JNIEnv * jni_env);
+	#else
+	void onSnoopPacket(const BtSnoopFileInfo &fileInfo,const BtSnoopPacketView &record);
+
+	void onFinishedCountingPackets(int packet_count);
+
+	void onError(int error_code,const std::string &error_message);
+	#endif //__ANDROID__
+
+private:
+
+	/**
+	 * @brief
+	 *      legacy listener
+	 */
+	IBtSnoopListener * listener;
+};
+
+#endif // BTSNOOPLISTENERADAPTER_H
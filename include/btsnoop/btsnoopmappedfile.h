@@ -0,0 +1,109 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopmappedfile.h
+
+	Read-only memory mapping of a whole btsnoop file
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPMAPPEDFILE_H
+#define BTSNOOPMAPPEDFILE_H
+
+#include "string"
+#include <stddef.h>
+
+class BtSnoopMappedFile
+{
+
+public:
+
+	BtSnoopMappedFile();
+
+	/**
+	 * @brief
+	 *      unmap file and close descriptor
+	 */
+	~BtSnoopMappedFile();
+
+	/**
+	 * @brief
+	 *      map the whole file in memory (read only)
+	 * @param file_path
+	 *      btsnoop file path
+	 * @return
+	 *      success status
+	 */
+	bool open(std::string file_path);
+
+	/**
+	 * @brief
+	 *      release current mapping
+	 */
+	void close();
+
+	/**
+	 * @brief
+	 *      get pointer to the first byte of the mapping
+	 * @return
+	 *      mapped data (0 if nothing is mapped)
+	 */
+	const char * data() const;
+
+	/**
+	 * @brief
+	 *      get size of the mapping
+	 * @return
+	 *      mapped size in bytes
+	 */
+	size_t size() const;
+
+private:
+
+	BtSnoopMappedFile(const BtSnoopMappedFile&);
+
+	BtSnoopMappedFile& operator=(const BtSnoopMappedFile&);
+
+	/**
+	 * @brief
+	 *      file descriptor of mapped file
+	 */
+	int fd;
+
+	/**
+	 * @brief
+	 *      start of mapping
+	 */
+	char * mapping;
+
+	/**
+	 * @brief
+	 *      size of mapping
+	 */
+	size_t mapping_size;
+};
+
+#endif // BTSNOOPMAPPEDFILE_H
@@ -0,0 +1,132 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopoffsetindex.h
+
+	Dense index of packet record positions (or timestamps) by packet number : values
+	are stored as 32 bit deltas from the first value of each block of records, a
+	block with a value not fitting 32 bits (negative or too big delta) is stored as
+	64 bit values
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPOFFSETINDEX_H
+#define BTSNOOPOFFSETINDEX_H
+
+#include "vector"
+#include <stddef.h>
+#include <inttypes.h>
+
+//number of values sharing the same 64 bit base value
+#define OFFSET_INDEX_BLOCK_SIZE 64
+
+//block stored as deltas
+#define OFFSET_INDEX_NARROW UINT32_MAX
+
+class BtSnoopOffsetIndex
+{
+
+public:
+
+	BtSnoopOffsetIndex();
+
+	/**
+	 * @brief
+	 *      append position (or timestamp) of next packet
+	 * @param value
+	 *      position in file (or timestamp)
+	 */
+	void push_back(int64_t value);
+
+	/**
+	 * @brief
+	 *      get position (or timestamp) of a packet
+	 * @param index
+	 *      packet number (< size())
+	 * @return
+	 */
+	int64_t get(size_t index) const;
+
+	int64_t operator[](size_t index) const;
+
+	/**
+	 * @brief
+	 *      get number of positions
+	 * @return
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief
+	 *      remove all positions
+	 */
+	void clear();
+
+	/**
+	 * @brief
+	 *      get memory used by index (allocated capacity)
+	 * @return
+	 *      number of bytes
+	 */
+	size_t getMemoryUsage() const;
+
+private:
+
+	/**
+	 * @brief
+	 *      store values of a block as 64 bit values (a delta does not fit 32 bits)
+	 * @param block
+	 *      block number
+	 */
+	void widen(size_t block);
+
+	/**
+	 * @brief
+	 *      first value of each block
+	 */
+	std::vector<int64_t> bases;
+
+	/**
+	 * @brief
+	 *      value minus base value of its block (0 in 64 bit blocks)
+	 */
+	std::vector<uint32_t> deltas;
+
+	/**
+	 * @brief
+	 *      position of each block in wide values / OFFSET_INDEX_BLOCK_SIZE
+	 *      (OFFSET_INDEX_NARROW for blocks stored as deltas)
+	 */
+	std::vector<uint32_t> wide_blocks;
+
+	/**
+	 * @brief
+	 *      values of blocks with a delta not fitting 32 bits
+	 */
+	std::vector<int64_t> wide;
+};
+
+#endif // BTSNOOPOFFSETINDEX_H
@@ -0,0 +1,79 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooppackedrecord.h
+
+	Compact fixed-size packet record : packet flags are stored as bits of the
+	length field, timestamp and original length are stored as deltas
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPPACKEDRECORD_H
+#define BTSNOOPPACKEDRECORD_H
+
+#include <inttypes.h>
+
+//packet flags bits in length_flags field
+#define PACKED_FLAG_RECEIVED      0x80000000
+#define PACKED_FLAG_COMMAND_EVENT 0x40000000
+
+//included length bits in length_flags field
+#define PACKED_LENGTH_MASK        0x3FFFFFFF
+
+struct BtSnoopPackedRecord
+{
+	/**
+	 * @brief
+	 *      timestamp in microseconds relative to timestamp of segment first record
+	 */
+	uint32_t timestamp_delta;
+
+	/**
+	 * @brief
+	 *      packet data offset in segment payload buffer
+	 */
+	uint32_t payload_offset;
+
+	/**
+	 * @brief
+	 *      included length (PACKED_LENGTH_MASK bits) and packet flags
+	 */
+	uint32_t length_flags;
+
+	/**
+	 * @brief
+	 *      original length minus included length (0 unless packet was truncated)
+	 */
+	uint32_t truncated_length;
+
+	/**
+	 * @brief
+	 *      number of packet lost between the first record and this record for this file
+	 */
+	uint32_t cumulative_drops;
+};
+
+#endif // BTSNOOPPACKEDRECORD_H
@@ -0,0 +1,239 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooppackedstore.h
+
+	Packet record store using compact packed records : records are grouped in
+	segments holding a base timestamp and the packet data of their records
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPPACKEDSTORE_H
+#define BTSNOOPPACKEDSTORE_H
+
+#include "vector"
+#include "deque"
+#include "btsnoop/btsnooppackedrecord.h"
+#include "btsnoop/btsnooppacketview.h"
+#include "btsnoop/btsnooppacket.h"
+#include "btsnoop/btsnoopdataspan.h"
+#include <stddef.h>
+#include <inttypes.h>
+
+//maximum number of records in one segment
+#define PACKED_SEGMENT_SIZE 4096
+
+struct BtSnoopPackedSegment
+{
+	/**
+	 * @brief
+	 *      index of first record of segment (counting removed records)
+	 */
+	size_t first_index;
+
+	/**
+	 * @brief
+	 *      btsnoop timestamp of first record of segment
+	 */
+	uint64_t base_timestamp;
+
+	/**
+	 * @brief
+	 *      packed records
+	 */
+	std::vector<BtSnoopPackedRecord> records;
+
+	/**
+	 * @brief
+	 *      packet data of all records one after the other
+	 */
+	std::vector<char> payloads;
+};
+
+class BtSnoopPackedStore
+{
+
+public:
+
+	BtSnoopPackedStore();
+
+	/**
+	 * @brief
+	 *      append a packet record (header fields and payload are copied)
+	 * @param record
+	 *      packet record view
+	 */
+	void append(const BtSnoopPacketView &record);
+
+	/**
+	 * @brief
+	 *      remove first record (memory of a segment is released with its last record)
+	 */
+	void pop_front();
+
+	/**
+	 * @brief
+	 *      remove all records
+	 */
+	void clear();
+
+	/**
+	 * @brief
+	 *      get number of records
+	 * @return
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief
+	 *      get memory used by records and packet data (allocated capacity)
+	 * @return
+	 *      number of bytes
+	 */
+	size_t getMemoryUsage() const;
+
+	/**
+	 * @brief
+	 *      get packed record
+	 * @param index
+	 *      record index (< size())
+	 * @return
+	 */
+	const BtSnoopPackedRecord & getPackedRecord(size_t index) const;
+
+	/**
+	 * @brief
+	 *      get btsnoop timestamp of a record (microseconds since 01/01/0 AD)
+	 * @param index
+	 *      record index
+	 * @return
+	 */
+	uint64_t getTimestamp(size_t index) const;
+
+	/**
+	 * @brief
+	 *      get length of original packet (could be more than included length)
+	 * @param index
+	 *      record index
+	 * @return
+	 */
+	uint32_t getOriginalLength(size_t index) const;
+
+	/**
+	 * @brief
+	 *      get packet data field length
+	 * @param index
+	 *      record index
+	 * @return
+	 */
+	uint32_t getIncludedLength(size_t index) const;
+
+	/**
+	 * @brief
+	 *      get number of packet lost between the first record and this record
+	 * @param index
+	 *      record index
+	 * @return
+	 */
+	uint32_t getCumulativeDrops(size_t index) const;
+
+	/**
+	 * @brief
+	 *      define if packet record is received (sent otherwise)
+	 * @param index
+	 *      record index
+	 * @return
+	 */
+	bool is_packet_received(size_t index) const;
+
+	/**
+	 * @brief
+	 *      define if packet record is command or event (data otherwise)
+	 * @param index
+	 *      record index
+	 * @return
+	 */
+	bool is_command_event(size_t index) const;
+
+	/**
+	 * @brief
+	 *      get packet data of a record without copy (valid until next append / clear)
+	 * @param index
+	 *      record index
+	 * @return
+	 */
+	BtSnoopDataSpan getPayload(size_t index) const;
+
+	/**
+	 * @brief
+	 *      build a packet owning a copy of a record
+	 * @param index
+	 *      record index
+	 * @return
+	 */
+	BtSnoopPacket toPacket(size_t index) const;
+
+private:
+
+	/**
+	 * @brief
+	 *      get segment containing a record
+	 * @param index
+	 *      record index
+	 * @param position
+	 *      record position in segment
+	 * @return
+	 */
+	const BtSnoopPackedSegment & segment(size_t index,size_t &position) const;
+
+	/**
+	 * @brief
+	 *      start a new segment (previous segment capacity is trimmed)
+	 * @param timestamp
+	 *      base timestamp of new segment
+	 */
+	void add_segment(uint64_t timestamp);
+
+	/**
+	 * @brief
+	 *      segments in record order
+	 */
+	std::deque<BtSnoopPackedSegment> segments;
+
+	/**
+	 * @brief
+	 *      number of appended records
+	 */
+	size_t count;
+
+	/**
+	 * @brief
+	 *      number of records removed from the front
+	 */
+	size_t removed;
+};
+
+#endif // BTSNOOPPACKEDSTORE_H
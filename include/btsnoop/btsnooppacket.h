@@ -35,8 +35,14 @@
 
 #include "vector"
 #include "string"
+#include "btsnoop/btsnooppayload.h"
+#include "btsnoop/btsnooparena.h"
 #include <inttypes.h>
 
+//packet flags bits (same as btsnoop record flags)
+#define PACKET_FLAG_RECEIVED      0x01
+#define PACKET_FLAG_COMMAND_EVENT 0x02
+
 class BtSnoopPacket
 {
 
@@ -50,7 +56,19 @@ public:
 	 * @param data
 	 *      data of size 24 (4 + 4 + 4 + 4 + 8)
 	 */
-	BtSnoopPacket(char * data);
+	BtSnoopPacket(const char * data);
+
+	/**
+	 * @brief
+	 *      copied packet owns its packet data, moved packet keeps arena packet data
+	 */
+	BtSnoopPacket(const BtSnoopPacket&) = default;
+
+	BtSnoopPacket(BtSnoopPacket&&) = default;
+
+	BtSnoopPacket& operator=(const BtSnoopPacket&) = default;
+
+	BtSnoopPacket& operator=(BtSnoopPacket&&) = default;
 
 	~BtSnoopPacket();
 
@@ -59,82 +77,113 @@ public:
 	 *      decode packet data field
 	 * @param data
 	 */
-	void decode_data(char * data);
+	void decode_data(const char * data);
+
+	/**
+	 * @brief
+	 *      decode packet data field into arena memory (packet data is valid until arena
+	 *      is cleared, copies of this packet own their data)
+	 * @param data
+	 * @param arena
+	 *      arena owning packet data
+	 */
+	void decode_data(const char * data,BtSnoopArena &arena);
 
 	/**
 	 * @brief
 	 *      get length of original packet (could be more than this packet's length)
 	 * @return
 	 */
-	int getOriginalLength();
+	int getOriginalLength() const;
 
 	/**
 	 * @brief
 	 *      get packet data field length
 	 * @return
 	 */
-	int getincludedLength();
+	int getincludedLength() const;
 
 	/**
 	 * @brief
 	 *      get number of packet lost between the first record and this record for this file
 	 * @return
 	 */
-	int getCumulativeDrops();
+	int getCumulativeDrops() const;
 
 	/**
 	 * @brief
 	 *      get unix timestamp for this packet record
 	 * @return
 	 */
-	uint64_t getUnixTimestampMicroseconds();
+	uint64_t getUnixTimestampMicroseconds() const;
+
+	/**
+	 * @brief
+	 *      get unix timestamp in nanoseconds for this packet record
+	 * @return
+	 */
+	uint64_t getUnixTimestampNanoseconds() const;
+
+	/**
+	 * @brief
+	 *      get btsnoop timestamp for this packet record (microseconds since 01/01/0 AD)
+	 * @return
+	 */
+	uint64_t getTimestamp() const;
 
 	/**
 	 * @brief
 	 *      define if packet record is sent
 	 * @return
 	 */
-	bool is_packet_sent();
+	bool is_packet_sent() const;
 
 	/**
 	 * @brief
 	 *      define if packet record is received
 	 * @return
 	 */
-	bool is_packet_received();
+	bool is_packet_received() const;
 
 	/**
 	 * @brief
 	 *      define if packet record is data record
 	 * @return
 	 */
-	bool is_data();
+	bool is_data() const;
 
 	/**
 	 * @brief
 	 *      define if packet record is command or event
 	 * @return
 	 */
-	bool is_command_event();
+	bool is_command_event() const;
 
 	/**
 	* @brief
 	*      retrieve packet data
 	* @return
 	*/
-	std::vector<char> getPacketData();
+	std::vector<char> getPacketData() const;
+
+	/**
+	 * @brief
+	 *      get packet data field without copy (valid while this packet exists)
+	 * @return
+	 */
+	BtSnoopDataSpan getPayload() const;
 
 	/**
 	 * @brief
 	 *      print info in debug mode
 	 */
-	void printInfo();
+	void printInfo() const;
 
 	/**
 	 * @brief
 	 *      convert packet to json
 	 */
-	std::string toJson(bool beautify);
+	std::string toJson(bool beautify) const;
 
 private:
 
@@ -158,43 +207,21 @@ private:
 
 	/**
 	 * @brief
-	 *      unix timestamp for this packet record
+	 *      packet flags (PACKET_FLAG_RECEIVED / PACKET_FLAG_COMMAND_EVENT bits)
 	 */
-	uint64_t timestamp_microseconds;
+	uint8_t flags;
 
 	/**
 	 * @brief
-	 *      packet data
+	 *      btsnoop timestamp for this packet record (microseconds since 01/01/0 AD)
 	 */
-	std::vector<char> packet_data;
+	uint64_t timestamp;
 
 	/**
 	 * @brief
-	 *      define if packet record is sent
-	 * @return
-	 */
-	bool packet_sent;
-
-	/**
-	 * @brief
-	 *      define if packet record is received
-	 * @return
-	 */
-	bool packet_received;
-
-	/**
-	 * @brief
-	 *      define if packet record is data record
-	 * @return
-	 */
-	bool packet_type_data;
-
-	/**
-	 * @brief
-	 *      define if packet record is command or event
-	 * @return
+	 *      packet data
 	 */
-	bool packet_type_command_event;
+	BtSnoopPayload packet_data;
 
 };
 
@@ -0,0 +1,255 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooppacketreader.h
+
+	Random access to packet records by packet number : record positions are
+	indexed once and pages of decoded packets are kept in a LRU cache
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPPACKETREADER_H
+#define BTSNOOPPACKETREADER_H
+
+#include "string"
+#include "vector"
+#include "list"
+#include "map"
+#include "btsnoop/btsnooppacket.h"
+#include "btsnoop/btsnoopfileinfo.h"
+#include "btsnoop/btsnoopoffsetindex.h"
+#include "btsnoop/btsnoopindexfile.h"
+#include <stddef.h>
+#include <inttypes.h>
+
+//number of packets decoded at once
+#define READER_PAGE_SIZE 256
+
+//default number of pages kept in cache
+#define READER_CACHE_PAGES 64
+
+//maximum capacity of page read buffer kept between two page reads
+#define READER_BUFFER_SIZE (1024 * 1024)
+
+struct BtSnoopReaderPage
+{
+	/**
+	 * @brief
+	 *      page number (first packet number / READER_PAGE_SIZE)
+	 */
+	size_t number;
+
+	/**
+	 * @brief
+	 *      decoded packets of page
+	 */
+	std::vector<BtSnoopPacket> packets;
+};
+
+class BtSnoopPacketReader
+{
+
+public:
+
+	BtSnoopPacketReader();
+
+	~BtSnoopPacketReader();
+
+	/**
+	 * @brief
+	 *      open btsnoop file and index position of all packet records
+	 * @param file_path
+	 *      btsnoop file path (uncompressed)
+	 * @param index_file
+	 *      use persistent sidecar index (<file>.idx) instead of reading all records
+	 * @return
+	 *      success status
+	 */
+	bool open(std::string file_path,bool index_file = false);
+
+	/**
+	 * @brief
+	 *      close btsnoop file and release index / cache
+	 */
+	void close();
+
+	/**
+	 * @brief
+	 *      index packet records appended to btsnoop file since last call (file being
+	 *      written)
+	 * @return
+	 *      number of new packets
+	 */
+	size_t refresh();
+
+	/**
+	 * @brief
+	 *      set maximum number of cached pages (READER_PAGE_SIZE packets each)
+	 * @param pages
+	 *      number of pages (at least 1)
+	 */
+	void set_cache_size(size_t pages);
+
+	/**
+	 * @brief
+	 *      get file information header object
+	 * @return
+	 */
+	BtSnoopFileInfo getFileInfo();
+
+	/**
+	 * @brief
+	 *      get number of indexed packets
+	 * @return
+	 */
+	size_t getPacketCount() const;
+
+	/**
+	 * @brief
+	 *      get a packet by number
+	 * @param number
+	 *      packet number (< getPacketCount())
+	 * @param packet
+	 *      decoded packet
+	 * @return
+	 *      success status
+	 */
+	bool getPacket(size_t number,BtSnoopPacket &packet);
+
+	/**
+	 * @brief
+	 *      get consecutive packets
+	 * @param first
+	 *      first packet number
+	 * @param count
+	 *      number of packets (less packets are returned at end of file)
+	 * @return
+	 *      decoded packets
+	 */
+	std::vector<BtSnoopPacket> getPackets(size_t first,size_t count);
+
+private:
+
+	BtSnoopPacketReader(const BtSnoopPacketReader&);
+
+	BtSnoopPacketReader& operator=(const BtSnoopPacketReader&);
+
+	/**
+	 * @brief
+	 *      get position of a packet record (or of end of indexed records)
+	 * @param number
+	 *      packet number (<= getPacketCount())
+	 * @return
+	 */
+	int64_t position(size_t number) const;
+
+	/**
+	 * @brief
+	 *      index position of packet records from end of indexed records
+	 * @return
+	 *      number of new packets
+	 */
+	size_t index_records();
+
+	/**
+	 * @brief
+	 *      get a page from cache or decode it
+	 * @param number
+	 *      page number
+	 * @return
+	 *      page (0 if it cant be read)
+	 */
+	const BtSnoopReaderPage * page(size_t number);
+
+	/**
+	 * @brief
+	 *      release read buffer if a page with big records made it grow over
+	 *      READER_BUFFER_SIZE
+	 */
+	void shrink_buffer();
+
+	/**
+	 * @brief
+	 *      btsnoop file descriptor
+	 */
+	int fd;
+
+	/**
+	 * @brief
+	 *      sidecar index path (empty if not used)
+	 */
+	std::string index_path;
+
+	/**
+	 * @brief
+	 *      file information header
+	 */
+	BtSnoopFileInfo fileInfo;
+
+	/**
+	 * @brief
+	 *      position of each packet record (when sidecar index is not used)
+	 */
+	BtSnoopOffsetIndex offsets;
+
+	/**
+	 * @brief
+	 *      position after last indexed packet record (when sidecar index is not used)
+	 */
+	int64_t indexed_end;
+
+	/**
+	 * @brief
+	 *      sidecar index
+	 */
+	BtSnoopIndexFile index_file;
+
+	/**
+	 * @brief
+	 *      cached pages, most recently used first
+	 */
+	std::list<BtSnoopReaderPage> cache;
+
+	/**
+	 * @brief
+	 *      cached pages by page number
+	 */
+	std::map<size_t, std::list<BtSnoopReaderPage>::iterator> cache_pages;
+
+	/**
+	 * @brief
+	 *      maximum number of cached pages
+	 */
+	size_t cache_size;
+
+	/**
+	 * @brief
+	 *      buffer of page records read from file (released above READER_BUFFER_SIZE)
+	 */
+	std::vector<char> buffer;
+};
+
+#endif // BTSNOOPPACKETREADER_H
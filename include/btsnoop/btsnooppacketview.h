@@ -0,0 +1,180 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooppacketview.h
+
+	Non-owning view over a bt snoop packet record. Header fields are decoded
+	on demand from the raw 24 bytes header
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPPACKETVIEW_H
+#define BTSNOOPPACKETVIEW_H
+
+#include "btsnoop/btsnooppacket.h"
+#include "btsnoop/btsnoopdataspan.h"
+#include <inttypes.h>
+
+class BtSnoopPacketView
+{
+
+public:
+
+	/**
+	 * @brief
+	 *      build a view over a packet record
+	 * @param header
+	 *      record header of size 24 (4 + 4 + 4 + 4 + 8)
+	 * @param data
+	 *      packet data field (included length bytes)
+	 */
+	BtSnoopPacketView(const char * header,const char * data);
+
+	/**
+	 * @brief
+	 *      get length of original packet (could be more than this packet's length)
+	 * @return
+	 */
+	int getOriginalLength() const;
+
+	/**
+	 * @brief
+	 *      get packet data field length
+	 * @return
+	 */
+	int getincludedLength() const;
+
+	/**
+	 * @brief
+	 *      get number of packet lost between the first record and this record for this file
+	 * @return
+	 */
+	int getCumulativeDrops() const;
+
+	/**
+	 * @brief
+	 *      get btsnoop timestamp for this packet record (microseconds since 01/01/0 AD)
+	 * @return
+	 */
+	uint64_t getTimestamp() const;
+
+	/**
+	 * @brief
+	 *      get unix timestamp for this packet record
+	 * @return
+	 */
+	uint64_t getUnixTimestampMicroseconds() const;
+
+	/**
+	 * @brief
+	 *      define if packet record is sent
+	 * @return
+	 */
+	bool is_packet_sent() const;
+
+	/**
+	 * @brief
+	 *      define if packet record is received
+	 * @return
+	 */
+	bool is_packet_received() const;
+
+	/**
+	 * @brief
+	 *      define if packet record is data record
+	 * @return
+	 */
+	bool is_data() const;
+
+	/**
+	 * @brief
+	 *      define if packet record is command or event
+	 * @return
+	 */
+	bool is_command_event() const;
+
+	/**
+	 * @brief
+	 *      get packet data field without copy
+	 * @return
+	 */
+	BtSnoopDataSpan getPayload() const;
+
+	/**
+	 * @brief
+	 *      get raw record header (24 bytes)
+	 * @return
+	 */
+	const char * getHeader() const;
+
+	/**
+	 * @brief
+	 *      get raw packet data field (included length bytes)
+	 * @return
+	 */
+	const char * getData() const;
+
+	/**
+	 * @brief
+	 *      build an owning packet from this view (header decoding + data copy)
+	 * @return
+	 */
+	BtSnoopPacket toPacket() const;
+
+	/**
+	 * @brief
+	 *      build a packet from this view with packet data copied into arena memory
+	 * @param arena
+	 *      arena owning packet data
+	 * @return
+	 */
+	BtSnoopPacket toPacket(BtSnoopArena &arena) const;
+
+private:
+
+	/**
+	 * @brief
+	 *      decode big endian 32 bit header field
+	 * @param offset
+	 *      field offset in header
+	 * @return
+	 */
+	uint32_t field(int offset) const;
+
+	/**
+	 * @brief
+	 *      record header
+	 */
+	const char * header;
+
+	/**
+	 * @brief
+	 *      packet data field
+	 */
+	const char * data;
+};
+
+#endif // BTSNOOPPACKETVIEW_H
@@ -37,6 +37,7 @@
 #include "fstream"
 #include "vector"
 #include "ibtsnooplistener.h"
+#include "ibtsnooprecordlistener.h"
 #include "btsnoopfileinfo.h"
 #include "pthread.h"
 #include "btsnoop/btsnooptask.h"
@@ -64,12 +65,48 @@ public:
 	 */
 	void addSnoopListener(IBtSnoopListener* listener);
 
+	/**
+	 * @brief
+	 *      add a record listener (views by const reference / batch delivery)
+	 * @param listener
+	 */
+	void addSnoopListener(IBtSnoopRecordListener* listener);
+
 	/**
 	 * @brief
 	 *      remove all listeners in snoop listener list
 	 */
 	 void clearListeners();
 
+	/**
+	 * @brief
+	 *      when streamed file is rotated (moved and recreated), decode packets remaining
+	 *      in rotated file before resuming from the header of the new file
+	 * @param drain_rotated
+	 *      drain rotated file (default true)
+	 */
+	void set_drain_rotated(bool drain_rotated);
+
+	/**
+	 * @brief
+	 *      bound packets retained by decoding task (oldest packets are evicted)
+	 * @param policy
+	 *      RETENTION_ALL (default), RETENTION_NONE (listeners only),
+	 *      RETENTION_LAST_PACKETS, RETENTION_LAST_SECONDS or RETENTION_BYTES
+	 * @param limit
+	 *      number of packets / seconds / bytes
+	 */
+	void set_retention_policy(retention_policy policy,uint64_t limit);
+
+	/**
+	 * @brief
+	 *      count packets of decode_streaming_file(file_path,packetNumber) with a
+	 *      persistent sidecar index (<file>.idx) updated with appended packets only
+	 * @param enabled
+	 *      use sidecar index (default false)
+	 */
+	void set_index_file(bool enabled);
+
 	/**
 	 * @brief
 	 *      decode streaming file
@@ -91,6 +128,16 @@ public:
 	 */
 	bool decode_streaming_file(std::string file_path, int packetNumber);
 
+	/**
+	 * @brief
+	 *      decode btsnoop data from a non-seekable byte source (stdin, FIFO, unix socket, TCP)
+	 * @param source
+	 *      byte source (must remain valid until decoding is stopped)
+	 * @return
+	 *      success status
+	 */
+	bool decode_streaming_source(IBtSnoopSource * source);
+
 	/**
 	 * @brief
 	 *      wait for thread to finish (blocking method)
@@ -105,6 +152,14 @@ public:
 
 private:
 
+	/**
+	 * @brief
+	 *      start decoding thread for current snoop task
+	 * @return
+	 *      success status
+	 */
+	bool start_decoding_task();
+
 	/**
 	 * @brief
 	 *      decode thread task
@@ -123,11 +178,41 @@ private:
 	 */
 	std::vector<IBtSnoopListener*> snoopListenerList;
 
+	/**
+	 * @brief
+	 *      list of record listener registered
+	 */
+	std::vector<IBtSnoopRecordListener*> recordListenerList;
+
 	/**
 	 * @brief
 	 *      define if a thread has already been created before
 	 */
 	bool thread_started;
+
+	/**
+	 * @brief
+	 *      decode packets remaining in rotated file before switching to new file
+	 */
+	bool drain_rotated;
+
+	/**
+	 * @brief
+	 *      retention policy of decoding task
+	 */
+	retention_policy retention;
+
+	/**
+	 * @brief
+	 *      retention limit of decoding task
+	 */
+	uint64_t retention_limit;
+
+	/**
+	 * @brief
+	 *      count packets with sidecar index file
+	 */
+	bool index_file;
 };
 
 #endif // BTSNOOPPARSER_H
@@ -0,0 +1,189 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooppayload.h
+
+	Packet data field stored inline (short payloads), in an owned heap buffer or
+	borrowed from a BtSnoopArena
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPPAYLOAD_H
+#define BTSNOOPPAYLOAD_H
+
+#include "btsnoop/btsnooparena.h"
+#include "btsnoop/btsnoopdataspan.h"
+#include <stddef.h>
+#include <inttypes.h>
+
+//payloads up to this size are stored in the packet object, in place of the pointer to external
+//memory (events, short commands / ACL)
+#define PAYLOAD_INLINE_SIZE 20
+
+//payload storage is kept in the 2 high bits of length (payloads are smaller than 1GB)
+#define PAYLOAD_LENGTH_MASK   0x3FFFFFFF
+#define PAYLOAD_STORAGE_SHIFT 30
+
+enum payload_storage{
+	PAYLOAD_INLINE,
+	PAYLOAD_HEAP,
+	PAYLOAD_ARENA
+};
+
+class BtSnoopPayload
+{
+
+public:
+
+	BtSnoopPayload();
+
+	/**
+	 * @brief
+	 *      copy of a payload is always owned : it remains valid when arena is released
+	 */
+	BtSnoopPayload(const BtSnoopPayload& payload);
+
+	BtSnoopPayload& operator=(const BtSnoopPayload& payload);
+
+	/**
+	 * @brief
+	 *      moved payload keeps pointing to the same memory (borrowed payload stays in arena)
+	 */
+	BtSnoopPayload(BtSnoopPayload&& payload) noexcept;
+
+	BtSnoopPayload& operator=(BtSnoopPayload&& payload) noexcept;
+
+	~BtSnoopPayload();
+
+	/**
+	 * @brief
+	 *      set payload to an owned copy of data (inline if short enough)
+	 * @param data
+	 *      data to copy
+	 * @param size
+	 *      number of bytes
+	 */
+	void assign(const char * data,size_t size);
+
+	/**
+	 * @brief
+	 *      set payload to a copy of data : short payloads are stored inline, others
+	 *      are allocated in arena (valid until arena is cleared)
+	 * @param data
+	 *      data to copy
+	 * @param size
+	 *      number of bytes
+	 * @param arena
+	 *      arena owning the copy
+	 */
+	void assign(const char * data,size_t size,BtSnoopArena &arena);
+
+	/**
+	 * @brief
+	 *      get first byte
+	 * @return
+	 */
+	const char * data() const;
+
+	/**
+	 * @brief
+	 *      get number of bytes
+	 * @return
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief
+	 *      get payload as a non-owning span
+	 * @return
+	 */
+	BtSnoopDataSpan span() const;
+
+	/**
+	 * @brief
+	 *      define if payload memory belongs to an arena
+	 * @return
+	 */
+	bool is_borrowed() const;
+
+	/**
+	 * @brief
+	 *      define if payload is stored in this object
+	 * @return
+	 */
+	bool is_inline() const;
+
+	char operator[](size_t index) const;
+
+private:
+
+	/**
+	 * @brief
+	 *      release heap buffer and set payload empty
+	 */
+	void release();
+
+	/**
+	 * @brief
+	 *      set payload to external memory
+	 * @param storage
+	 *      heap (owned) or arena memory
+	 * @param ptr
+	 *      first byte
+	 * @param size
+	 *      number of bytes
+	 */
+	void set_external(payload_storage storage,const char * ptr,size_t size);
+
+	/**
+	 * @brief
+	 *      get where payload is stored
+	 * @return
+	 */
+	payload_storage getStorage() const;
+
+	/**
+	 * @brief
+	 *      get first byte of heap buffer or arena memory
+	 * @return
+	 */
+	const char * getExternal() const;
+
+	/**
+	 * @brief
+	 *      inline buffer, or pointer to heap buffer / arena memory (unaligned, read
+	 *      and written with memcpy)
+	 */
+	char inline_data[PAYLOAD_INLINE_SIZE];
+
+	/**
+	 * @brief
+	 *      number of bytes and payload storage (high bits)
+	 */
+	uint32_t length;
+};
+
+#endif // BTSNOOPPAYLOAD_H
@@ -0,0 +1,183 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooprecordrange.h
+
+	Non-copying range over packet records retained by a decoding task. Iterators
+	are index based : they remain valid while new records are appended
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPRECORDRANGE_H
+#define BTSNOOPRECORDRANGE_H
+
+#include "deque"
+#include "iterator"
+#include "btsnoop/btsnooppacket.h"
+#include <stddef.h>
+
+class BtSnoopRecordRange
+{
+
+public:
+
+	class const_iterator
+	{
+
+	public:
+
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef BtSnoopPacket value_type;
+		typedef ptrdiff_t difference_type;
+		typedef const BtSnoopPacket * pointer;
+		typedef const BtSnoopPacket & reference;
+
+		const_iterator() : records(0), index(0) {}
+
+		const_iterator(const std::deque<BtSnoopPacket> * records,size_t index) : records(records), index(index) {}
+
+		reference operator*() const { return (*records)[index]; }
+
+		pointer operator->() const { return &(*records)[index]; }
+
+		reference operator[](difference_type offset) const { return (*records)[index + offset]; }
+
+		const_iterator& operator++() { index++; return *this; }
+
+		const_iterator operator++(int) { const_iterator it = *this; index++; return it; }
+
+		const_iterator& operator--() { index--; return *this; }
+
+		const_iterator operator--(int) { const_iterator it = *this; index--; return it; }
+
+		const_iterator& operator+=(difference_type offset) { index += offset; return *this; }
+
+		const_iterator& operator-=(difference_type offset) { index -= offset; return *this; }
+
+		const_iterator operator+(difference_type offset) const { return const_iterator(records, index + offset); }
+
+		const_iterator operator-(difference_type offset) const { return const_iterator(records, index - offset); }
+
+		difference_type operator-(const const_iterator &it) const { return (difference_type)index - (difference_type)it.index; }
+
+		bool operator==(const const_iterator &it) const { return index == it.index && records == it.records; }
+
+		bool operator!=(const const_iterator &it) const { return !(*this == it); }
+
+		bool operator<(const const_iterator &it) const { return index < it.index; }
+
+		bool operator>(const const_iterator &it) const { return index > it.index; }
+
+		bool operator<=(const const_iterator &it) const { return index <= it.index; }
+
+		bool operator>=(const const_iterator &it) const { return index >= it.index; }
+
+	private:
+
+		/**
+		 * @brief
+		 *      iterated records
+		 */
+		const std::deque<BtSnoopPacket> * records;
+
+		/**
+		 * @brief
+		 *      index of current record
+		 */
+		size_t index;
+	};
+
+	/**
+	 * @brief
+	 *      build a range over records [begin, end[
+	 * @param records
+	 *      retained records
+	 * @param begin
+	 *      index of first record
+	 * @param end
+	 *      index after last record
+	 */
+	BtSnoopRecordRange(const std::deque<BtSnoopPacket> * records,size_t begin,size_t end);
+
+	/**
+	 * @brief
+	 *      get iterator on first record
+	 * @return
+	 */
+	const_iterator begin() const;
+
+	/**
+	 * @brief
+	 *      get iterator after last record
+	 * @return
+	 */
+	const_iterator end() const;
+
+	/**
+	 * @brief
+	 *      get number of records in range
+	 * @return
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief
+	 *      define if range is empty
+	 * @return
+	 */
+	bool empty() const;
+
+	/**
+	 * @brief
+	 *      get record by position in range
+	 * @param index
+	 *      position in range
+	 * @return
+	 */
+	const BtSnoopPacket & operator[](size_t index) const;
+
+private:
+
+	/**
+	 * @brief
+	 *      retained records
+	 */
+	const std::deque<BtSnoopPacket> * records;
+
+	/**
+	 * @brief
+	 *      index of first record
+	 */
+	size_t first;
+
+	/**
+	 * @brief
+	 *      index after last record
+	 */
+	size_t last;
+};
+
+#endif // BTSNOOPRECORDRANGE_H
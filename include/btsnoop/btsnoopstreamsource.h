@@ -0,0 +1,160 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopstreamsource.h
+
+	Non-seekable btsnoop byte source : stdin, FIFO, unix domain socket or TCP connection
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPSTREAMSOURCE_H
+#define BTSNOOPSTREAMSOURCE_H
+
+#include "string"
+#include "pthread.h"
+#include "btsnoop/ibtsnoopsource.h"
+
+class BtSnoopStreamSource : public IBtSnoopSource
+{
+
+public:
+
+	BtSnoopStreamSource();
+
+	/**
+	 * @brief
+	 *      close stream
+	 */
+	~BtSnoopStreamSource();
+
+	/**
+	 * @brief
+	 *      read from standard input
+	 * @return
+	 *      success status
+	 */
+	bool open_stdin();
+
+	/**
+	 * @brief
+	 *      read from a FIFO or character device (blocks until a FIFO writer is connected)
+	 * @param path
+	 *      FIFO path
+	 * @return
+	 *      success status
+	 */
+	bool open_path(std::string path);
+
+	/**
+	 * @brief
+	 *      connect to a unix domain stream socket
+	 * @param socket_path
+	 *      socket path
+	 * @return
+	 *      success status
+	 */
+	bool connect_unix(std::string socket_path);
+
+	/**
+	 * @brief
+	 *      connect to a TCP server (for instance btsnoop socket port forwarded from an Android device)
+	 * @param host
+	 *      host name or address
+	 * @param port
+	 *      TCP port
+	 * @return
+	 *      success status
+	 */
+	bool connect_tcp(std::string host,int port);
+
+	/**
+	 * @brief
+	 *      close stream (stdin is left open)
+	 */
+	void close();
+
+	/**
+	 * @brief
+	 *      read next bytes (blocking until at least one byte is available)
+	 * @param data
+	 *      destination buffer
+	 * @param size
+	 *      maximum number of bytes to read
+	 * @return
+	 *      number of bytes read, 0 on end of stream / interrupted, -1 on error
+	 */
+	ssize_t read(char * data,size_t size);
+
+	/**
+	 * @brief
+	 *      make pending and next read() return end of stream (may be called from any thread)
+	 */
+	void interrupt();
+
+private:
+
+	BtSnoopStreamSource(const BtSnoopStreamSource&);
+
+	BtSnoopStreamSource& operator=(const BtSnoopStreamSource&);
+
+	/**
+	 * @brief
+	 *      use file descriptor as stream
+	 * @param fd
+	 *      opened file descriptor
+	 * @param owned
+	 *      close file descriptor when closing stream
+	 * @return
+	 *      success status
+	 */
+	bool attach(int fd,bool owned);
+
+	/**
+	 * @brief
+	 *      stream file descriptor
+	 */
+	int fd;
+
+	/**
+	 * @brief
+	 *      define if file descriptor is closed with stream
+	 */
+	bool owned;
+
+	/**
+	 * @brief
+	 *      self-pipe used to interrupt read()
+	 */
+	int interrupt_pipe[2];
+
+	/**
+	 * @brief
+	 *      protect descriptors between interrupt() and close()
+	 */
+	pthread_mutex_t lock;
+};
+
+#endif // BTSNOOPSTREAMSOURCE_H
@@ -25,17 +25,35 @@
 #define BTSNOOPTASK_H
 
 #include "string"
-#include "fstream"
 #include "btsnoop/btsnoopstate.h"
 #include "btsnoop/btsnoopfileinfo.h"
 #include "btsnoop/btsnooppacket.h"
+#include "btsnoop/btsnoopfilewatcher.h"
+#include "btsnoop/btsnoopblockreader.h"
+#include "btsnoop/btsnooparena.h"
+#include "btsnoop/btsnooprecordrange.h"
+#include "btsnoop/btsnoopcolumnstore.h"
+#include "btsnoop/btsnooppackedstore.h"
+#include "btsnoop/btsnoopretention.h"
+#include "btsnoop/btsnoopindexfile.h"
+#include "btsnoop/btsnooptimeindex.h"
+#include "deque"
 #include "ibtsnooplistener.h"
-#include "map"
+#include "ibtsnooprecordlistener.h"
+#include "btsnoop/btsnooplisteneradapter.h"
+#include "ibtsnoopsource.h"
+#include <inttypes.h>
 
 #ifdef __ANDROID__
 #include "jni.h"
 #endif //__ANDROID__
 
+//maximum number of packet record views delivered in one batch
+#define TASK_BATCH_MAX_SIZE 1024
+
+//number of record headers decoded at once when counting packet records
+#define TASK_INDEX_BATCH_SIZE 256
+
 class BtSnoopTask
 {
 
@@ -77,6 +95,16 @@ public:
 	 */
 	BtSnoopTask(std::string file_path,std::vector<IBtSnoopListener*> *snoopListenerList,int packet_number);
 
+	/**
+	 * @brief
+	 *      build decoding task reading a non-seekable byte source (stdin, FIFO, socket)
+	 * @param source
+	 *      byte source (must remain valid until decoding is stopped)
+	 * @param snoopListenerList
+	 *       list of listeners to be notified when a packet is decoded
+	 */
+	BtSnoopTask(IBtSnoopSource * source,std::vector<IBtSnoopListener*> *snoopListenerList);
+
 	~BtSnoopTask();
 
 	/**
@@ -85,7 +113,7 @@ public:
 	 * @return
 	 *      last <packet_number> packet index
 	 */
-	int get_last_n_packet_index(int packet_number);
+	int64_t get_last_n_packet_index(int packet_number);
 
 	/**
 	 * @brief
@@ -96,31 +124,161 @@ public:
 	/**
 	 * @brief
 	 *      decode full snoop file header / packet record data
-	 * @param fileStream
-	 *      file
+	 * @param fd
+	 *      file descriptor (only read with pread, file offset is not used)
 	 * @param current_position
 	 *      current position of file (initial is 0 / cant be -1)
-	 * @param fill_index_table
-	 * 		set to true if packet index table is filled each time a packet is decoded
+	 * @param count_only
+	 * 		set to true if packet records are only counted (end position of last records
+	 * 		kept in tail ring) instead of being decoded
 	 * @return
 	 *      new position of file (to match with incoming changes)
 	 */
-	int decode_streaming_file(std::ifstream *fileStream,int current_position,bool fill_index_table);
+	int64_t decode_streaming_file(int fd,int64_t current_position,bool count_only);
 
 	/**
 	 * @brief
-	 *      decode full snoop file header / packet record data
+	 *      decode full snoop file header / packet record data. gzip and zstd compressed
+	 *      files (detected from magic bytes) are decompressed in a dedicated thread
 	 * @return
 	 *      success status
 	 */
 	bool decode_file();
 
+	/**
+	 * @brief
+	 *      decode full snoop file header / packet record data from a read-only memory
+	 *      mapping of the file. Listeners receive packet views pointing directly into
+	 *      the mapping (valid only during the callback) and no packet is kept in
+	 *      packet data records list
+	 * @return
+	 *      success status
+	 */
+	bool decode_file_mapped();
+
+	/**
+	 * @brief
+	 *      decode only packet records with a timestamp in [begin, end[. Record offsets
+	 *      and timestamps are indexed (sidecar index is used if enabled) and matching
+	 *      records are found by binary search over block timestamp bounds, so that
+	 *      records with non-monotonic timestamps are also found. Index is kept between
+	 *      two calls and only extended with records appended to the file
+	 * @param begin
+	 *      first unix timestamp in microseconds
+	 * @param end
+	 *      unix timestamp in microseconds after last one
+	 * @return
+	 *      success status (compressed files are not supported)
+	 */
+	bool decode_time_range(uint64_t begin,uint64_t end);
+
 	/**
 	 * @brief
 	 *      stop decoding : exit control loop
 	 */
 	void stop();
 
+	/**
+	 * @brief
+	 *      read whole file passes (decode_file / packet counting) with several
+	 *      io_uring reads in flight. Plain reads are used if io_uring is not available
+	 * @param async_read
+	 *      enable asynchronous reads
+	 */
+	void set_async_read(bool async_read);
+
+	/**
+	 * @brief
+	 *      when streamed file is rotated (moved and recreated), decode packets remaining
+	 *      in rotated file before resuming from the header of the new file
+	 * @param drain_rotated
+	 *      drain rotated file (default true)
+	 */
+	void set_drain_rotated(bool drain_rotated);
+
+	/**
+	 * @brief
+	 *      count packets with a persistent sidecar index (<file>.idx) : only packet
+	 *      records appended since index was saved are read
+	 * @param enabled
+	 *      use sidecar index (default false)
+	 */
+	void set_index_file(bool enabled);
+
+	/**
+	 * @brief
+	 *      fill columnar store with decoded packets (in addition to packet data records).
+	 *      Packets evicted by retention policy are removed from column store by batch of
+	 *      COLUMN_BATCH_SIZE packets (decode_file_mapped keeps all packets of the file)
+	 * @param enabled
+	 *      enable columnar store (default false)
+	 */
+	void set_column_store(bool enabled);
+
+	/**
+	 * @brief
+	 *      get columnar store of decoded packets (empty if not enabled)
+	 * @return
+	 */
+	const BtSnoopColumnStore & getColumnStore() const;
+
+	/**
+	 * @brief
+	 *      retain decoded packets as packed records instead of packet objects (for long
+	 *      streaming sessions). getRecords() / getRecord() are then empty and
+	 *      getPacketDataRecords() builds packets from packed records
+	 * @param enabled
+	 *      enable packed records (default false)
+	 */
+	void set_packed_records(bool enabled);
+
+	/**
+	 * @brief
+	 *      get packed records store of decoded packets (empty if not enabled)
+	 * @return
+	 */
+	const BtSnoopPackedStore & getPackedStore() const;
+
+	/**
+	 * @brief
+	 *      bound retained packets (packet data records or packed store). Oldest packets
+	 *      are evicted in constant time once limit is exceeded. Eviction shifts record
+	 *      indexes : ranges from getRecords() must not be kept across decoding. Bounded
+	 *      packet data records are not arena backed : payloads bigger than
+	 *      PAYLOAD_INLINE_SIZE are heap allocated (use packed records to avoid it).
+	 *      Column store follows the same policy by batch of COLUMN_BATCH_SIZE packets
+	 * @param policy
+	 *      RETENTION_ALL (default), RETENTION_NONE (listeners only),
+	 *      RETENTION_LAST_PACKETS, RETENTION_LAST_SECONDS or RETENTION_BYTES
+	 * @param limit
+	 *      number of packets / seconds before last packet timestamp / bytes (24 byte
+	 *      record header + packet data per packet)
+	 */
+	void set_retention_policy(retention_policy policy,uint64_t limit);
+
+	/**
+	 * @brief
+	 *      get number of packets evicted (or not retained) because of retention policy
+	 * @return
+	 */
+	uint64_t getEvictedCount() const;
+
+	/**
+	 * @brief
+	 *      get size of retained packets (24 byte record header + packet data per packet)
+	 * @return
+	 *      number of bytes
+	 */
+	uint64_t getRetainedBytes() const;
+
+	/**
+	 * @brief
+	 *      set list of record listeners notified in addition to packet listeners
+	 * @param recordListenerList
+	 *      list of record listeners (must remain valid while decoding)
+	 */
+	void set_record_listeners(std::vector<IBtSnoopRecordListener*> *recordListenerList);
+
 	/**
 	 * @brief
 	 *      get file information header object
@@ -136,6 +294,31 @@ public:
 	 *      list of btsnoop decoded packets
 	 */
 	std::vector<BtSnoopPacket> getPacketDataRecords();
+
+	/**
+	 * @brief
+	 *      get range over decoded packets without copy (records appended later are not
+	 *      part of the range, its iterators remain valid)
+	 * @return
+	 *      range of retained packets
+	 */
+	BtSnoopRecordRange getRecords() const;
+
+	/**
+	 * @brief
+	 *      get number of retained packets
+	 * @return
+	 */
+	size_t getRecordCount() const;
+
+	/**
+	 * @brief
+	 *      get a retained packet without copy
+	 * @param index
+	 *      packet index (< getRecordCount())
+	 * @return
+	 */
+	const BtSnoopPacket & getRecord(size_t index) const;
 	
 	static void *decoding_helper(void *context) {
 		return ((BtSnoopTask *)context)->decoding_task();
@@ -147,16 +330,198 @@ public:
 
 private:
 
+	/**
+	 * @brief
+	 *      monitor snoop file for changes and decode appended packet records
+	 */
+	void stream_file();
+
+	/**
+	 * @brief
+	 *      retain a decoded packet according to retention policy
+	 * @param view
+	 *      packet record view
+	 */
+	void retain(const BtSnoopPacketView &view);
+
+	/**
+	 * @brief
+	 *      evict oldest retained packets while retention limit is exceeded
+	 * @param timestamp
+	 *      timestamp of last retained packet
+	 */
+	void evict(uint64_t timestamp);
+
+	/**
+	 * @brief
+	 *      evict packets from column store by batch of COLUMN_BATCH_SIZE packets (column
+	 *      store keeps at most COLUMN_BATCH_SIZE packets more than retained packets)
+	 * @param count
+	 *      number of packets evicted by retention policy
+	 */
+	void evict_columns(size_t count);
+
+	/**
+	 * @brief
+	 *      remove all retained packets and reset retention counters
+	 */
+	void clear_records();
+
+	/**
+	 * @brief
+	 *      build list of notified listeners : legacy listeners are wrapped in adapters
+	 */
+	void init_listeners();
+
+	/**
+	 * @brief
+	 *      deliver pending packet record views to all listeners
+	 */
+	void notify_batch();
+
+	/**
+	 * @brief
+	 *      detect snoop file rotation (new inode at file path), truncation (file smaller
+	 *      than current position) or rewrite (file header changed). Streaming restarts
+	 *      from the header of the current file without reading previous packets again
+	 * @param index
+	 *      current position in streamed file (reset to 0 if file has changed)
+	 * @return
+	 *      true if file has changed (stream_fd is -1 if new file does not exist yet)
+	 */
+	bool check_rotation(int64_t &index);
+
+	/**
+	 * @brief
+	 *      read file header and start decoding packet records
+	 * @param fd
+	 *      file descriptor
+	 * @return
+	 *      success status
+	 */
+	bool read_file_header(int fd);
+
+	/**
+	 * @brief
+	 *      decode packet records from byte source until end of stream / stop
+	 */
+	void stream_source();
+
+	/**
+	 * @brief
+	 *      read file by blocks and decode all complete packet records
+	 * @param fd
+	 *      file descriptor
+	 * @param position
+	 *      position of first packet record
+	 * @param end
+	 *      position where reading stops (-1 to read until end of file)
+	 * @param count_only
+	 * 		set to true if packet records are only counted (end position of last records
+	 * 		kept in tail ring) instead of being decoded
+	 * @param packet_count
+	 *      number of counted packets (incremented for each record)
+	 * @param bulk
+	 *      whole file is read : asynchronous reads are used if enabled
+	 * @return
+	 *      position after last complete packet record
+	 */
+	int64_t read_records(int fd,int64_t position,int64_t end,bool count_only,int &packet_count,bool bulk);
+
+	/**
+	 * @brief
+	 *      decode all complete packet records read by block reader until end of data
+	 * @param count_only
+	 * 		set to true if packet records are only counted (end position of last records
+	 * 		kept in tail ring) instead of being decoded
+	 * @param packet_count
+	 *      number of counted packets (incremented for each record)
+	 * @return
+	 *      position after last complete packet record
+	 */
+	int64_t decode_blocks(bool count_only,int &packet_count);
+
+	/**
+	 * @brief
+	 *      decode all complete packet records in a buffer
+	 * @param data
+	 *      buffer starting with a packet record
+	 * @param size
+	 *      buffer size
+	 * @param position
+	 *      file position of buffer
+	 * @param count_only
+	 * 		set to true if packet records are only counted (end position of last records
+	 * 		kept in tail ring) instead of being decoded
+	 * @param packet_count
+	 *      number of counted packets (incremented for each record)
+	 * @return
+	 *      number of bytes consumed (incomplete trailing record is not consumed)
+	 */
+	size_t decode_records(const char * data,size_t size,int64_t position,bool count_only,int &packet_count);
+
+	/**
+	 * @brief
+	 *      count all complete packet records in a buffer and keep end position of last ones
+	 *      in tail ring (record headers are decoded by batch)
+	 * @param data
+	 *      buffer starting with a packet record
+	 * @param size
+	 *      buffer size
+	 * @param position
+	 *      file position of buffer
+	 * @param packet_count
+	 *      number of counted packets (incremented for each record)
+	 * @return
+	 *      number of bytes consumed (incomplete trailing record is not consumed)
+	 */
+	size_t index_records(const char * data,size_t size,int64_t position,int &packet_count);
+
 	/**
 	 * btsnoop file path
 	 */
 	std::string file_path;
 
+	/**
+	 * byte source used instead of file path (0 if decoding a file)
+	 */
+	IBtSnoopSource * source;
+
 	/**
 	 * control variable to stop decoding thread if necessary
 	 */
 	bool task_control;
 
+	/**
+	 * wait for streamed file changes between two decoding iterations
+	 */
+	BtSnoopFileWatcher file_watcher;
+
+	/**
+	 * file descriptor kept open during streaming session (-1 if not streaming)
+	 */
+	int stream_fd;
+
+	/**
+	 * read whole file passes with io_uring
+	 */
+	bool async_read;
+
+	/**
+	 * decode packets remaining in rotated file before switching to new file
+	 */
+	bool drain_rotated;
+
+	/**
+	 * raw header of streamed file (checked to detect a rewritten file)
+	 */
+	char stream_header[16];
+
+	/**
+	 * block reader used to parse packet records in place
+	 */
+	BtSnoopBlockReader block_reader;
+
 	/**
 	 * decoding state
 	 */
@@ -173,26 +538,108 @@ private:
 	std::vector<IBtSnoopListener*> *snoopListenerList;
 
 	/**
-	 * packet index table map 
+	 * list of record listeners (listener interface with const references / batches)
+	 */
+	std::vector<IBtSnoopRecordListener*> *recordListenerList;
+
+	/**
+	 * adapters delivering records to packet listeners
+	 */
+	std::vector<BtSnoopListenerAdapter> listener_adapters;
+
+	/**
+	 * all notified listeners (adapters + record listeners)
+	 */
+	std::vector<IBtSnoopRecordListener*> listeners;
+
+	/**
+	 * packet record views decoded in current read cycle, not delivered yet
+	 */
+	std::vector<BtSnoopPacketView> batch;
+
+	/**
+	 * end position of last records when counting packets for a tail-N start (not
+	 * filled if empty)
+	 */
+	std::vector<int64_t> tail_ring;
+
+	/**
+	 * number of records counted when filling tail ring
+	 */
+	size_t tail_count;
+
+	/**
+	 * list of all decoded packets (currently decoded). Appending never moves
+	 * previous packets
+	 */
+	std::deque<BtSnoopPacket> packetDataRecords;
+
+	/**
+	 * memory of packet data retained in packet data records (released with the list)
+	 */
+	BtSnoopArena payload_arena;
+
+	/**
+	 * columnar copy of decoded packets
 	 */
-	std::map<int, int> index_table;
+	BtSnoopColumnStore column_store;
 
 	/**
-	 * list of all decoded packets (currently decoded)
+	 * fill columnar store
 	 */
-	std::vector<BtSnoopPacket> packetDataRecords;
+	bool column_store_enabled;
 
-	/* packet header value (24 o)*/
-	char * packet_header;
+	/**
+	 * retained packets stored as packed records
+	 */
+	BtSnoopPackedStore packed_store;
+
+	/**
+	 * retain packets in packed store instead of packet data records
+	 */
+	bool packed_records_enabled;
+
+	/**
+	 * retention policy of decoded packets
+	 */
+	retention_policy retention;
 
-	/* packet data value (dynamic size)*/
-	char * packet_data;
+	/**
+	 * retention limit (packets, seconds or bytes depending on policy)
+	 */
+	uint64_t retention_limit;
 
-	/* packet data index count*/
-	int data_index;
+	/**
+	 * number of packets evicted by retention policy
+	 */
+	uint64_t evicted_count;
 
-	/* current packet*/
-	BtSnoopPacket packet;
+	/**
+	 * size of retained packets (record header + packet data)
+	 */
+	uint64_t retained_bytes;
+
+	/**
+	 * number of evicted packets still in column store
+	 */
+	size_t column_evicted;
+
+	/**
+	 * count packets with sidecar index file
+	 */
+	bool index_file_enabled;
+
+	/**
+	 * record index / block timestamp bounds used by decode_time_range (not copied)
+	 */
+	BtSnoopIndexFile time_range_index;
+
+	BtSnoopTimeIndex time_range_bounds;
+
+	/**
+	 * number of packets counted by get_last_n_packet_index
+	 */
+	int64_t packet_total;
 
 	/* number of packet to decoded (from the end to the beginning) */
 	int packet_number;
@@ -0,0 +1,113 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooptimeindex.h
+
+	Timestamp range search over a packet record index : minimum / maximum
+	timestamp of each block of records are used to skip blocks, so that
+	non-monotonic timestamps (clock adjustments) are still found
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPTIMEINDEX_H
+#define BTSNOOPTIMEINDEX_H
+
+#include "vector"
+#include "utility"
+#include "btsnoop/btsnoopindexfile.h"
+#include <stddef.h>
+#include <inttypes.h>
+
+//number of records sharing the same minimum / maximum timestamp
+#define TIME_INDEX_BLOCK_SIZE 256
+
+class BtSnoopTimeIndex
+{
+
+public:
+
+	BtSnoopTimeIndex();
+
+	/**
+	 * @brief
+	 *      extend block timestamp bounds to records added to a record index (bounds
+	 *      are rebuilt if index has less records than bounds cover)
+	 * @param index
+	 *      record index
+	 */
+	void update(const BtSnoopIndexFile &index);
+
+	/**
+	 * @brief
+	 *      discard block timestamp bounds
+	 */
+	void clear();
+
+	/**
+	 * @brief
+	 *      find records with a timestamp in [begin, end[
+	 * @param index
+	 *      record index (bounds must be up to date with update())
+	 * @param begin
+	 *      first btsnoop timestamp (microseconds since 01/01/0 AD)
+	 * @param end
+	 *      btsnoop timestamp after last one
+	 * @param ranges
+	 *      ranges of consecutive matching records [first record, last record + 1[ in
+	 *      file order
+	 */
+	void query(const BtSnoopIndexFile &index,uint64_t begin,uint64_t end,std::vector<std::pair<size_t,size_t> > &ranges) const;
+
+private:
+
+	/**
+	 * @brief
+	 *      number of records covered by block bounds
+	 */
+	size_t count;
+
+	/**
+	 * @brief
+	 *      minimum / maximum timestamp of each block
+	 */
+	std::vector<uint64_t> block_min;
+
+	std::vector<uint64_t> block_max;
+
+	/**
+	 * @brief
+	 *      maximum timestamp of blocks up to each block (non decreasing)
+	 */
+	std::vector<uint64_t> prefix_max;
+
+	/**
+	 * @brief
+	 *      minimum timestamp of blocks from each block (non decreasing)
+	 */
+	std::vector<uint64_t> suffix_min;
+};
+
+#endif // BTSNOOPTIMEINDEX_H
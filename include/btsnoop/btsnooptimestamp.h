@@ -0,0 +1,177 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooptimestamp.h
+
+	Convert btsnoop record timestamps (microseconds since 01/01/0 AD) without
+	any time zone / libc call : safe to use from several decoding threads
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPTIMESTAMP_H
+#define BTSNOOPTIMESTAMP_H
+
+#include "vector"
+#include "btsnoop/btsnooppacket.h"
+#include "btsnoop/btsnooprecordrange.h"
+#include "btsnoop/btsnooptimestampformat.h"
+#include <stddef.h>
+#include <inttypes.h>
+
+//btsnoop timestamp of 01/01/2000 00:00:00 UTC (microseconds since 01/01/0 AD)
+#define DATE_0AD_TO_YEAR2000 0x00E03AB44A676000ULL
+
+//unix time of 01/01/2000 00:00:00 UTC in seconds
+#define DATE_UNIX_TO_YEAR2000 946684800ULL
+
+class BtSnoopTimestamp
+{
+
+public:
+
+	/**
+	 * @brief
+	 *      offset between btsnoop timestamp and unix timestamp in microseconds
+	 */
+	static constexpr uint64_t UNIX_OFFSET_MICROSECONDS = DATE_0AD_TO_YEAR2000 - DATE_UNIX_TO_YEAR2000 * 1000000;
+
+	/**
+	 * @brief
+	 *      convert btsnoop timestamp to unix timestamp in microseconds
+	 * @param raw
+	 *      btsnoop timestamp
+	 * @return
+	 */
+	static constexpr uint64_t toUnixMicroseconds(uint64_t raw){
+		return raw - UNIX_OFFSET_MICROSECONDS;
+	}
+
+	/**
+	 * @brief
+	 *      convert btsnoop timestamp to unix timestamp in nanoseconds
+	 * @param raw
+	 *      btsnoop timestamp
+	 * @return
+	 */
+	static constexpr uint64_t toUnixNanoseconds(uint64_t raw){
+		return (raw - UNIX_OFFSET_MICROSECONDS) * 1000;
+	}
+
+	/**
+	 * @brief
+	 *      decode btsnoop timestamp from a record header
+	 * @param header
+	 *      record header of size 24 (timestamp is the last 8 bytes, big endian)
+	 * @return
+	 */
+	static uint64_t decode(const char * header);
+
+	/**
+	 * @brief
+	 *      build timestamp converter
+	 * @param format
+	 *      output format
+	 */
+	BtSnoopTimestamp(timestamp_format format = TIMESTAMP_UNIX_MICROSECONDS);
+
+	/**
+	 * @brief
+	 *      convert one btsnoop timestamp. In relative format, first converted
+	 *      timestamp is the origin (result in microseconds)
+	 * @param raw
+	 *      btsnoop timestamp
+	 * @return
+	 *      converted timestamp
+	 */
+	int64_t convert(uint64_t raw);
+
+	/**
+	 * @brief
+	 *      convert an array of btsnoop timestamps
+	 * @param raw
+	 *      btsnoop timestamps
+	 * @param output
+	 *      converted timestamps (count values)
+	 * @param count
+	 *      number of timestamps
+	 */
+	void convert(const uint64_t * raw,int64_t * output,size_t count);
+
+	/**
+	 * @brief
+	 *      convert timestamps of a list of packet records
+	 * @param records
+	 *      decoded packet records
+	 * @param output
+	 *      converted timestamps (one per record)
+	 */
+	void convert(const std::vector<BtSnoopPacket> &records,std::vector<int64_t> &output);
+
+	/**
+	 * @brief
+	 *      convert timestamps of a range of retained packet records
+	 * @param records
+	 *      packet records
+	 * @param output
+	 *      converted timestamps (one per record)
+	 */
+	void convert(const BtSnoopRecordRange &records,std::vector<int64_t> &output);
+
+	/**
+	 * @brief
+	 *      forget origin of relative timestamps (next converted timestamp is the new origin)
+	 */
+	void reset();
+
+	/**
+	 * @brief
+	 *      get output format
+	 * @return
+	 */
+	timestamp_format getFormat();
+
+private:
+
+	/**
+	 * @brief
+	 *      output format
+	 */
+	timestamp_format format;
+
+	/**
+	 * @brief
+	 *      btsnoop timestamp of first converted record (relative format)
+	 */
+	uint64_t origin;
+
+	/**
+	 * @brief
+	 *      define if origin has been set
+	 */
+	bool origin_set;
+};
+
+#endif // BTSNOOPTIMESTAMP_H
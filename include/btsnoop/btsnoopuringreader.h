@@ -0,0 +1,207 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopuringreader.h
+
+	Sequential file reader keeping several io_uring reads in flight
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef BTSNOOPURINGREADER_H
+#define BTSNOOPURINGREADER_H
+
+#include "vector"
+#include <stddef.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+//number of reads kept in flight
+#define URING_READER_DEPTH 4
+
+class BtSnoopUringReader
+{
+
+public:
+
+	BtSnoopUringReader();
+
+	/**
+	 * @brief
+	 *      ring state is not copied : copy is a closed reader
+	 */
+	BtSnoopUringReader(const BtSnoopUringReader&);
+
+	BtSnoopUringReader& operator=(const BtSnoopUringReader&);
+
+	~BtSnoopUringReader();
+
+	/**
+	 * @brief
+	 *      create io_uring instance and queue first reads
+	 * @param fd
+	 *      file descriptor
+	 * @param position
+	 *      position of first byte to read
+	 * @param end
+	 *      position where reading stops
+	 * @param block_size
+	 *      size of one read
+	 * @return
+	 *      false if io_uring is not available (not built in / not supported by kernel)
+	 */
+	bool open(int fd,int64_t position,int64_t end,size_t block_size);
+
+	/**
+	 * @brief
+	 *      wait for pending reads and release io_uring instance
+	 */
+	void close();
+
+	/**
+	 * @brief
+	 *      define if reader is opened
+	 * @return
+	 */
+	bool is_open() const;
+
+	/**
+	 * @brief
+	 *      read next bytes of file (sequential)
+	 * @param data
+	 *      destination buffer
+	 * @param size
+	 *      maximum number of bytes to read
+	 * @return
+	 *      number of bytes read, 0 on end of file, -1 on error
+	 */
+	ssize_t read(char * data,size_t size);
+
+private:
+
+	/**
+	 * @brief
+	 *      queue a read of next block in a slot
+	 */
+	void submit(int slot);
+
+	/**
+	 * @brief
+	 *      wait for at least one completion and dispatch all completions to their slot
+	 * @return
+	 *      success status
+	 */
+	bool reap();
+
+	/**
+	 * @brief
+	 *      file descriptor being read
+	 */
+	int fd;
+
+	/**
+	 * @brief
+	 *      io_uring file descriptor
+	 */
+	int ring_fd;
+
+	/**
+	 * @brief
+	 *      submission/completion rings and submission entries mappings
+	 */
+	void * sq_ring;
+	size_t sq_ring_size;
+	void * cq_ring;
+	size_t cq_ring_size;
+	void * sqes;
+	size_t sqes_size;
+
+	/**
+	 * @brief
+	 *      ring indexes (pointers into mappings)
+	 */
+	unsigned * sq_tail;
+	unsigned * sq_mask;
+	unsigned * sq_array;
+	unsigned * cq_head;
+	unsigned * cq_tail;
+	unsigned * cq_mask;
+	void * cqes;
+
+	/**
+	 * @brief
+	 *      read slots (one buffer per read in flight)
+	 */
+	struct read_slot {
+		std::vector<char> buffer;
+		int64_t position;
+		size_t length;
+		bool pending;
+		ssize_t result;
+		size_t consumed;
+		struct iovec iov;
+	};
+
+	read_slot slots[URING_READER_DEPTH];
+
+	/**
+	 * @brief
+	 *      slot holding next bytes to be read
+	 */
+	int current_slot;
+
+	/**
+	 * @brief
+	 *      number of reads in flight
+	 */
+	int inflight;
+
+	/**
+	 * @brief
+	 *      file position of next queued read
+	 */
+	int64_t submit_position;
+
+	/**
+	 * @brief
+	 *      position where reading stops
+	 */
+	int64_t end_position;
+
+	/**
+	 * @brief
+	 *      size of one read
+	 */
+	size_t block_size;
+
+	/**
+	 * @brief
+	 *      set when a short read has been reached
+	 */
+	bool eof;
+};
+
+#endif // BTSNOOPURINGREADER_H
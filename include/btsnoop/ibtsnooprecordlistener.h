@@ -0,0 +1,159 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	ibtsnooprecordlistener.h
+
+	Packet record listener receiving views by const reference, optionally by batch
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef IBTSNOOPRECORDLISTENER_H
+#define IBTSNOOPRECORDLISTENER_H
+
+#include "btsnoopfileinfo.h"
+#include "btsnooperror.h"
+#include "btsnooppacketview.h"
+#include "string"
+#include <stddef.h>
+
+#ifdef __ANDROID__
+#include "jni.h"
+#endif //__ANDROID__
+
+class IBtSnoopRecordListener
+{
+
+public:
+
+	virtual ~IBtSnoopRecordListener(){}
+
+	#ifdef __ANDROID__
+	/**
+	 * @brief
+	 *      called when a new packet record has been decoded. View is only valid during
+	 *      this call (use toPacket() to keep it)
+	 * @param fileInfo
+	 *      file info object
+	 * @param record
+	 *      non-owning snoop packet record view
+	 * @param jni_env
+	 *      JNI env object
+	 */
+	virtual void onSnoopPacket(const BtSnoopFileInfo &fileInfo,const BtSnoopPacketView &record,JNIEnv * jni_env) = 0;
+
+	/**
+	 * @brief
+	 *      called with all packet records decoded in one read cycle. Views are only
+	 *      valid during this call, default implementation calls onSnoopPacket for each record
+	 * @param fileInfo
+	 *      file info object
+	 * @param records
+	 *      contiguous array of packet record views
+	 * @param count
+	 *      number of records
+	 * @param jni_env
+	 *      JNI env object
+	 */
+	virtual void onSnoopPacketBatch(const BtSnoopFileInfo &fileInfo,const BtSnoopPacketView * records,size_t count,JNIEnv * jni_env){
+		for (size_t i = 0; i < count;i++){
+			onSnoopPacket(fileInfo,records[i],jni_env);
+		}
+	}
+
+	/**
+	 * @brief
+	 * 		called when packet counting is completed
+	 * @param packet_count
+	 *      total packet count
+	 * @param jni_env
+	 *      JNI env object
+	 */
+	virtual void onFinishedCountingPackets(int /*packet_count*/,JNIEnv * /*jni_env*/){}
+
+	/**
+	 * @brief
+	 * 		called when and error occured
+	 * @param error_code
+	 *      error code
+	 * @param error_message
+	 *      error message
+	 * @param jni_env
+	 *      JNI env object
+	 */
+	virtual void onError(int /*error_code*/,const std::string &/*error_message*/,JNIEnv * /*jni_env*/){}
+
+	#else
+
+	/**
+	 * @brief
+	 *      called when a new packet record has been decoded. View is only valid during
+	 *      this call (use toPacket() to keep it)
+	 * @param fileInfo
+	 *      file info object
+	 * @param record
+	 *      non-owning snoop packet record view
+	 */
+	virtual void onSnoopPacket(const BtSnoopFileInfo &fileInfo,const BtSnoopPacketView &record) = 0;
+
+	/**
+	 * @brief
+	 *      called with all packet records decoded in one read cycle. Views are only
+	 *      valid during this call, default implementation calls onSnoopPacket for each record
+	 * @param fileInfo
+	 *      file info object
+	 * @param records
+	 *      contiguous array of packet record views
+	 * @param count
+	 *      number of records
+	 */
+	virtual void onSnoopPacketBatch(const BtSnoopFileInfo &fileInfo,const BtSnoopPacketView * records,size_t count){
+		for (size_t i = 0; i < count;i++){
+			onSnoopPacket(fileInfo,records[i]);
+		}
+	}
+
+	/**
+	 * @brief
+	 * 		called when packet counting is completed
+	 * @param packet_count
+	 *      total packet count
+	 */
+	virtual void onFinishedCountingPackets(int /*packet_count*/){}
+
+	/**
+	 * @brief
+	 * 		called when and error occured
+	 * @param error_code
+	 *      error code
+	 * @param error_message
+	 *      error message
+	 */
+	virtual void onError(int /*error_code*/,const std::string &/*error_message*/){}
+
+	#endif //__ANDROID__
+};
+
+#endif // IBTSNOOPRECORDLISTENER_H
@@ -0,0 +1,65 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	ibtsnoopsource.h
+
+	sequential source of btsnoop bytes (file content not read with pread)
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#ifndef IBTSNOOPSOURCE_H
+#define IBTSNOOPSOURCE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+class IBtSnoopSource
+{
+
+public:
+
+	virtual ~IBtSnoopSource(){}
+
+	/**
+	 * @brief
+	 *      read next bytes (blocking until at least one byte is available)
+	 * @param data
+	 *      destination buffer
+	 * @param size
+	 *      maximum number of bytes to read
+	 * @return
+	 *      number of bytes read, 0 on end of data, -1 on error
+	 */
+	virtual ssize_t read(char * data,size_t size) = 0;
+
+	/**
+	 * @brief
+	 *      make pending and next read() return end of data (may be called from any thread)
+	 */
+	virtual void interrupt(){}
+};
+
+#endif // IBTSNOOPSOURCE_H
@@ -0,0 +1,153 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooparena.cpp
+
+	Bump allocator for packet payloads : memory is taken from large slabs and
+	released all at once
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnooparena.h"
+#include <string.h>
+
+/**
+ * @brief
+ *      build empty arena
+ * @param slab_size
+ *      size of one slab
+ */
+BtSnoopArena::BtSnoopArena(size_t slab_size){
+	this->slab_size = slab_size;
+	current = 0;
+	remaining = 0;
+	used_size = 0;
+}
+
+/**
+ * @brief
+ *      memory is not copied : copy is an empty arena
+ */
+BtSnoopArena::BtSnoopArena(const BtSnoopArena& arena){
+	slab_size = arena.slab_size;
+	current = 0;
+	remaining = 0;
+	used_size = 0;
+}
+
+BtSnoopArena& BtSnoopArena::operator=(const BtSnoopArena& arena){
+	if (this != &arena){
+		clear();
+		slab_size = arena.slab_size;
+	}
+	return *this;
+}
+
+BtSnoopArena::~BtSnoopArena(){
+	clear();
+}
+
+/**
+ * @brief
+ *      allocate memory valid until clear() / arena destruction
+ * @param size
+ *      number of bytes
+ * @return
+ *      allocated memory
+ */
+char * BtSnoopArena::allocate(size_t size){
+
+	if (size > remaining){
+
+		if (size > slab_size / 4){
+
+			//big payload : dedicated slab, current slab is kept for next allocations
+			char * slab = new char[size];
+			slabs.push_back(slab);
+			used_size += size;
+			return slab;
+		}
+
+		current = new char[slab_size];
+		remaining = slab_size;
+		slabs.push_back(current);
+	}
+
+	char * ptr = current;
+
+	current += size;
+	remaining -= size;
+	used_size += size;
+
+	return ptr;
+}
+
+/**
+ * @brief
+ *      copy data into arena
+ * @param data
+ *      data to copy
+ * @param size
+ *      number of bytes
+ * @return
+ *      copy of data
+ */
+const char * BtSnoopArena::copy(const char * data,size_t size){
+
+	if (size == 0){
+		return 0;
+	}
+
+	char * ptr = allocate(size);
+	memcpy(ptr, data, size);
+
+	return ptr;
+}
+
+/**
+ * @brief
+ *      release all slabs (memory allocated previously is no longer valid)
+ */
+void BtSnoopArena::clear(){
+
+	for (unsigned int i = 0; i < slabs.size();i++){
+		delete[] slabs[i];
+	}
+	slabs.clear();
+
+	current = 0;
+	remaining = 0;
+	used_size = 0;
+}
+
+/**
+ * @brief
+ *      get number of bytes allocated since last clear()
+ * @return
+ */
+size_t BtSnoopArena::used() const{
+	return used_size;
+}
@@ -0,0 +1,247 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopblockreader.cpp
+
+	Read btsnoop file by large blocks, records are parsed in place
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnoopblockreader.h"
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+/**
+ * @brief
+ *      build block reader
+ * @param block_size
+ *      size of one read
+ */
+BtSnoopBlockReader::BtSnoopBlockReader(size_t block_size){
+	fd = -1;
+	source = 0;
+	this->block_size = block_size;
+	read_position = 0;
+	end_position = -1;
+	begin = 0;
+	end = 0;
+}
+
+/**
+ * @brief
+ *      start reading a file descriptor at a given position (buffered data is dropped)
+ * @param fd
+ *      file descriptor (read with pread, file offset is not used)
+ * @param position
+ *      position of first byte to read
+ * @param end
+ *      position where reading stops (-1 to read until end of file)
+ * @param async
+ *      keep several reads in flight with io_uring (plain pread if not available)
+ */
+void BtSnoopBlockReader::reset(int fd,int64_t position,int64_t end,bool async){
+	this->fd = fd;
+	source = 0;
+	read_position = position;
+	end_position = end;
+	begin = 0;
+	this->end = 0;
+
+	uring_reader.close();
+
+	if (async){
+
+		int64_t async_end = end;
+
+		if (async_end == -1){
+			struct stat file_stat;
+			async_end = (fstat(fd, &file_stat) == 0) ? (int64_t)file_stat.st_size : position;
+		}
+		if (async_end > position){
+			uring_reader.open(fd, position, async_end, block_size);
+		}
+	}
+}
+
+/**
+ * @brief
+ *      continue reading a file descriptor after buffered data (file has grown). Bytes
+ *      of an incomplete record read previously are kept and are not read again
+ * @param fd
+ *      file descriptor
+ * @param position
+ *      expected position of first byte not consumed yet
+ * @param end
+ *      position where reading stops (-1 to read until end of file)
+ * @return
+ *      false if reader is not positioned on this descriptor / position (reset() must be used)
+ */
+bool BtSnoopBlockReader::resume(int fd,int64_t position,int64_t end){
+
+	if (fd == -1 || source != 0 || this->fd != fd || this->position() != position){
+		return false;
+	}
+	end_position = end;
+
+	uring_reader.close();
+
+	return true;
+}
+
+/**
+ * @brief
+ *      start reading a sequential source (buffered data is dropped), position
+ *      is the number of bytes read from source
+ * @param source
+ *      byte source
+ */
+void BtSnoopBlockReader::reset(IBtSnoopSource * source){
+	fd = -1;
+	this->source = source;
+	read_position = 0;
+	end_position = -1;
+	begin = 0;
+	end = 0;
+
+	uring_reader.close();
+}
+
+/**
+ * @brief
+ *      read next block after buffered data. Data not consumed yet is moved to the
+ *      front of the buffer so that a record straddling two blocks is contiguous
+ * @param min_available
+ *      buffer is grown if needed so that this number of bytes can be buffered
+ *      (record bigger than block size)
+ * @return
+ *      number of bytes read (0 on end of file / error)
+ */
+size_t BtSnoopBlockReader::fill(size_t min_available){
+
+	size_t pending = end - begin;
+
+	if (begin > 0){
+		if (pending > 0){
+			memmove(&buffer[0], &buffer[begin], pending);
+		}
+		begin = 0;
+		end = pending;
+	}
+
+	size_t capacity = block_size;
+
+	if (capacity < min_available){
+		capacity = min_available;
+	}
+	if (buffer.size() < capacity){
+		buffer.resize(capacity);
+	}
+
+	size_t read_size = buffer.size() - end;
+
+	if (end_position != -1){
+
+		if (read_position >= end_position){
+			return 0;
+		}
+		if ((int64_t)read_size > end_position - read_position){
+			read_size = end_position - read_position;
+		}
+	}
+
+	if (read_size == 0){
+		return 0;
+	}
+
+	ssize_t count = -1;
+
+	if (source != 0){
+		count = source->read(&buffer[end], read_size);
+	}
+	else if (uring_reader.is_open()){
+
+		count = uring_reader.read(&buffer[end], read_size);
+
+		if (count <= 0){
+			//io_uring read failed or reached its end position : continue with pread
+			uring_reader.close();
+		}
+	}
+
+	if (count <= 0 && source == 0){
+		do {
+			count = pread(fd, &buffer[end], read_size, read_position);
+		} while (count == -1 && errno == EINTR);
+	}
+
+	if (count <= 0){
+		return 0;
+	}
+
+	end += count;
+	read_position += count;
+
+	return count;
+}
+
+/**
+ * @brief
+ *      get first buffered byte not consumed yet
+ * @return
+ */
+const char * BtSnoopBlockReader::data() const{
+	return buffer.empty() ? 0 : &buffer[begin];
+}
+
+/**
+ * @brief
+ *      get number of buffered bytes not consumed yet
+ * @return
+ */
+size_t BtSnoopBlockReader::available() const{
+	return end - begin;
+}
+
+/**
+ * @brief
+ *      mark bytes as consumed
+ * @param size
+ *      number of bytes (must be <= available())
+ */
+void BtSnoopBlockReader::consume(size_t size){
+	begin += size;
+}
+
+/**
+ * @brief
+ *      get file position of data()
+ * @return
+ */
+int64_t BtSnoopBlockReader::position() const{
+	return read_position - (end - begin);
+}
@@ -0,0 +1,310 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopcolumnstore.cpp
+
+	Columnar packet record store : one contiguous array per header field and all
+	payloads in a single byte heap
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnoopcolumnstore.h"
+#include "btsnoop/btsnoopheaderdecoder.h"
+#include <string.h>
+
+BtSnoopColumnStore::BtSnoopColumnStore(){
+	payload_offsets.push_back(0);
+}
+
+/**
+ * @brief
+ *      append a packet record (header fields and payload are copied)
+ * @param record
+ *      packet record view
+ */
+void BtSnoopColumnStore::append(const BtSnoopPacketView &record){
+
+	timestamps.push_back(record.getTimestamp());
+	original_lengths.push_back(record.getOriginalLength());
+	included_lengths.push_back(record.getincludedLength());
+	cumulative_drops.push_back(record.getCumulativeDrops());
+	flags.push_back(record.getHeader()[11] & (COLUMN_FLAG_RECEIVED | COLUMN_FLAG_COMMAND_EVENT));
+
+	BtSnoopDataSpan payload = record.getPayload();
+
+	payload_heap.insert(payload_heap.end(), payload.begin(), payload.end());
+	payload_offsets.push_back(payload_heap.size());
+}
+
+/**
+ * @brief
+ *      append all complete packet records at the beginning of a buffer (headers
+ *      are decoded by batch)
+ * @param data
+ *      buffer starting with a packet record
+ * @param size
+ *      buffer size
+ * @return
+ *      number of bytes used by appended records
+ */
+size_t BtSnoopColumnStore::append(const char * data,size_t size){
+
+	size_t total = 0;
+
+	while (size - total >= 24){
+
+		//columns grow by bounded batches (at most one record per 24 bytes) : a full
+		//mapped file would reserve size / 24 entries per column otherwise
+		size_t max_count = (size - total) / 24;
+
+		if (max_count > COLUMN_BATCH_SIZE){
+			max_count = COLUMN_BATCH_SIZE;
+		}
+
+		size_t consumed = append_batch(data + total, size - total, max_count);
+
+		if (consumed == 0){
+			break;
+		}
+		total += consumed;
+	}
+
+	return total;
+}
+
+/**
+ * @brief
+ *      append at most max_count complete packet records at the beginning of a buffer
+ * @param data
+ *      buffer starting with a packet record
+ * @param size
+ *      buffer size
+ * @param max_count
+ *      maximum number of records
+ * @return
+ *      number of bytes used by appended records
+ */
+size_t BtSnoopColumnStore::append_batch(const char * data,size_t size,size_t max_count){
+
+	size_t first = timestamps.size();
+
+	timestamps.resize(first + max_count);
+	original_lengths.resize(first + max_count);
+	included_lengths.resize(first + max_count);
+	cumulative_drops.resize(first + max_count);
+	flags.resize(first + max_count);
+
+	if (offsets.size() < max_count){
+		offsets.resize(max_count);
+	}
+
+	BtSnoopHeaderColumns columns;
+	columns.offsets = &offsets[0];
+	columns.original_lengths = &original_lengths[first];
+	columns.included_lengths = &included_lengths[first];
+	columns.flags = &flags[first];
+	columns.cumulative_drops = &cumulative_drops[first];
+	columns.timestamps = &timestamps[first];
+
+	size_t consumed = 0;
+	size_t count = BtSnoopHeaderDecoder::decode(data, size, max_count, columns, consumed);
+
+	timestamps.resize(first + count);
+	original_lengths.resize(first + count);
+	included_lengths.resize(first + count);
+	cumulative_drops.resize(first + count);
+	flags.resize(first + count);
+
+	for (size_t i = 0; i < count;i++){
+		flags[first + i] &= (COLUMN_FLAG_RECEIVED | COLUMN_FLAG_COMMAND_EVENT);
+	}
+
+	//payloads are copied with one resize of the heap
+	size_t heap_size = payload_heap.size();
+
+	payload_heap.resize(heap_size + consumed - count * 24);
+	payload_offsets.reserve(payload_offsets.size() + count);
+
+	for (size_t i = 0; i < count;i++){
+
+		uint32_t length = included_lengths[first + i];
+
+		if (length > 0){
+			memcpy(&payload_heap[heap_size], data + offsets[i] + 24, length);
+		}
+		heap_size += length;
+		payload_offsets.push_back(heap_size);
+	}
+
+	return consumed;
+}
+
+/**
+ * @brief
+ *      remove oldest records (columns are shifted : remove by batch)
+ * @param count
+ *      number of records (<= size())
+ */
+void BtSnoopColumnStore::pop_front(size_t count){
+
+	if (count == 0){
+		return;
+	}
+
+	timestamps.erase(timestamps.begin(), timestamps.begin() + count);
+	original_lengths.erase(original_lengths.begin(), original_lengths.begin() + count);
+	included_lengths.erase(included_lengths.begin(), included_lengths.begin() + count);
+	cumulative_drops.erase(cumulative_drops.begin(), cumulative_drops.begin() + count);
+	flags.erase(flags.begin(), flags.begin() + count);
+
+	uint64_t removed = payload_offsets[count];
+
+	payload_heap.erase(payload_heap.begin(), payload_heap.begin() + removed);
+	payload_offsets.erase(payload_offsets.begin(), payload_offsets.begin() + count);
+
+	for (size_t i = 0; i < payload_offsets.size();i++){
+		payload_offsets[i] -= removed;
+	}
+}
+
+/**
+ * @brief
+ *      remove all records
+ */
+void BtSnoopColumnStore::clear(){
+	timestamps.clear();
+	original_lengths.clear();
+	included_lengths.clear();
+	cumulative_drops.clear();
+	flags.clear();
+	payload_heap.clear();
+	payload_offsets.resize(1);
+}
+
+/**
+ * @brief
+ *      reserve memory for a number of records
+ * @param count
+ *      number of records
+ * @param payload_size
+ *      total payload size
+ */
+void BtSnoopColumnStore::reserve(size_t count,size_t payload_size){
+	timestamps.reserve(count);
+	original_lengths.reserve(count);
+	included_lengths.reserve(count);
+	cumulative_drops.reserve(count);
+	flags.reserve(count);
+	payload_offsets.reserve(count + 1);
+	payload_heap.reserve(payload_size);
+}
+
+/**
+ * @brief
+ *      get number of records
+ * @return
+ */
+size_t BtSnoopColumnStore::size() const{
+	return timestamps.size();
+}
+
+/**
+ * @brief
+ *      get btsnoop timestamps column (microseconds since 01/01/0 AD)
+ * @return
+ */
+const uint64_t * BtSnoopColumnStore::getTimestamps() const{
+	return timestamps.empty() ? 0 : &timestamps[0];
+}
+
+/**
+ * @brief
+ *      get original lengths column
+ * @return
+ */
+const uint32_t * BtSnoopColumnStore::getOriginalLengths() const{
+	return original_lengths.empty() ? 0 : &original_lengths[0];
+}
+
+/**
+ * @brief
+ *      get included lengths column
+ * @return
+ */
+const uint32_t * BtSnoopColumnStore::getIncludedLengths() const{
+	return included_lengths.empty() ? 0 : &included_lengths[0];
+}
+
+/**
+ * @brief
+ *      get cumulative drops column
+ * @return
+ */
+const uint32_t * BtSnoopColumnStore::getCumulativeDrops() const{
+	return cumulative_drops.empty() ? 0 : &cumulative_drops[0];
+}
+
+/**
+ * @brief
+ *      get packet flags column (COLUMN_FLAG_RECEIVED / COLUMN_FLAG_COMMAND_EVENT bits)
+ * @return
+ */
+const uint8_t * BtSnoopColumnStore::getFlags() const{
+	return flags.empty() ? 0 : &flags[0];
+}
+
+/**
+ * @brief
+ *      get payload offsets in payload heap (size() + 1 values, payload i is
+ *      [offset i, offset i + 1[)
+ * @return
+ */
+const uint64_t * BtSnoopColumnStore::getPayloadOffsets() const{
+	return &payload_offsets[0];
+}
+
+/**
+ * @brief
+ *      get payload heap (all payloads one after the other)
+ * @return
+ */
+const char * BtSnoopColumnStore::getPayloadHeap() const{
+	return payload_heap.empty() ? 0 : &payload_heap[0];
+}
+
+/**
+ * @brief
+ *      get payload of a record without copy (valid until next append / clear)
+ * @param index
+ *      record index
+ * @return
+ */
+BtSnoopDataSpan BtSnoopColumnStore::getPayload(size_t index) const{
+
+	uint64_t begin = payload_offsets[index];
+
+	return BtSnoopDataSpan(getPayloadHeap() + begin, payload_offsets[index + 1] - begin);
+}
@@ -0,0 +1,511 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopdecompresssource.cpp
+
+	Decompress gzip/zstd btsnoop file in a dedicated thread (pipelined with decoding)
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnoopdecompresssource.h"
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifdef BTSNOOP_ZLIB
+#include <zlib.h>
+#endif // BTSNOOP_ZLIB
+
+#ifdef BTSNOOP_ZSTD
+#include <zstd.h>
+#endif // BTSNOOP_ZSTD
+
+//size of one compressed read
+#define DECOMPRESS_INPUT_SIZE (256 * 1024)
+
+BtSnoopDecompressSource::BtSnoopDecompressSource(){
+	fd = -1;
+	input_position = 0;
+	type = COMPRESSION_NONE;
+	thread_started = false;
+	chunk_offset = 0;
+	finished = false;
+	failed = false;
+	stopped = false;
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&cond, NULL);
+}
+
+/**
+ * @brief
+ *      stop and join decompression thread
+ */
+BtSnoopDecompressSource::~BtSnoopDecompressSource(){
+	close();
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&lock);
+}
+
+/**
+ * @brief
+ *      detect compression format from first bytes of file
+ * @param data
+ *      first bytes of file
+ * @param size
+ *      number of bytes
+ * @return
+ *      compression format
+ */
+compression_type BtSnoopDecompressSource::detect(const char * data,size_t size){
+
+	const unsigned char * magic = (const unsigned char *)data;
+
+	if (size >= 2 && magic[0] == 0x1F && magic[1] == 0x8B){
+		return COMPRESSION_GZIP;
+	}
+	if (size >= 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD){
+		return COMPRESSION_ZSTD;
+	}
+	return COMPRESSION_NONE;
+}
+
+/**
+ * @brief
+ *      define if a compression format has been built in
+ * @param type
+ *      compression format
+ * @return
+ */
+bool BtSnoopDecompressSource::is_supported(compression_type type){
+
+	switch (type){
+		#ifdef BTSNOOP_ZLIB
+		case COMPRESSION_GZIP:
+			return true;
+		#endif // BTSNOOP_ZLIB
+		#ifdef BTSNOOP_ZSTD
+		case COMPRESSION_ZSTD:
+			return true;
+		#endif // BTSNOOP_ZSTD
+		default:
+			return false;
+	}
+}
+
+/**
+ * @brief
+ *      start decompressing file in decompression thread
+ * @param fd
+ *      compressed file descriptor (read with pread from the beginning)
+ * @param type
+ *      compression format
+ * @return
+ *      success status (false if format is not supported)
+ */
+bool BtSnoopDecompressSource::open(int fd,compression_type type){
+
+	close();
+
+	if (!is_supported(type)){
+		return false;
+	}
+
+	this->fd = fd;
+	this->type = type;
+	input_position = 0;
+	chunk_offset = 0;
+	finished = false;
+	failed = false;
+	stopped = false;
+
+	int rc = pthread_create(&decompress_thread, NULL, &BtSnoopDecompressSource::decompress_helper, (void*)this);
+
+	if (rc){
+		return false;
+	}
+	thread_started = true;
+
+	return true;
+}
+
+/**
+ * @brief
+ *      stop and join decompression thread
+ */
+void BtSnoopDecompressSource::close(){
+
+	if (thread_started){
+
+		pthread_mutex_lock(&lock);
+		stopped = true;
+		pthread_cond_broadcast(&cond);
+		pthread_mutex_unlock(&lock);
+
+		(void)pthread_join(decompress_thread, NULL);
+		thread_started = false;
+	}
+
+	chunks.clear();
+	free_chunks.clear();
+	fd = -1;
+}
+
+/**
+ * @brief
+ *      read next decompressed bytes (blocking until decompression thread provides some)
+ * @param data
+ *      destination buffer
+ * @param size
+ *      maximum number of bytes to read
+ * @return
+ *      number of bytes read, 0 on end of data, -1 on decompression error
+ */
+ssize_t BtSnoopDecompressSource::read(char * data,size_t size){
+
+	if (!thread_started){
+		return -1;
+	}
+
+	pthread_mutex_lock(&lock);
+
+	while (chunks.empty() && !finished && !failed){
+		pthread_cond_wait(&cond, &lock);
+	}
+
+	ssize_t count = 0;
+
+	if (!chunks.empty()){
+
+		std::vector<char> &chunk = chunks.front();
+
+		count = chunk.size() - chunk_offset;
+
+		if ((size_t)count > size){
+			count = size;
+		}
+
+		memcpy(data, &chunk[chunk_offset], count);
+		chunk_offset += count;
+
+		if (chunk_offset == chunk.size()){
+			free_chunks.push_back(std::vector<char>());
+			free_chunks.back().swap(chunk);
+			chunks.pop_front();
+			chunk_offset = 0;
+			pthread_cond_broadcast(&cond);
+		}
+	}
+	else if (failed){
+		count = -1;
+	}
+
+	pthread_mutex_unlock(&lock);
+
+	return count;
+}
+
+/**
+ * @brief
+ *      define if decompression failed (corrupted or truncated file). Final once read()
+ *      has returned 0 or -1
+ * @return
+ */
+bool BtSnoopDecompressSource::has_failed(){
+
+	pthread_mutex_lock(&lock);
+	bool result = failed;
+	pthread_mutex_unlock(&lock);
+
+	return result;
+}
+
+/**
+ * @brief
+ *      decompression thread task
+ */
+void * BtSnoopDecompressSource::decompress_task(void){
+
+	bool success = false;
+
+	switch (type){
+		case COMPRESSION_GZIP:
+			success = inflate_gzip();
+			break;
+		case COMPRESSION_ZSTD:
+			success = inflate_zstd();
+			break;
+		default:
+			break;
+	}
+
+	pthread_mutex_lock(&lock);
+	finished = true;
+	failed = !success && !stopped;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&lock);
+
+	return 0;
+}
+
+/**
+ * @brief
+ *      read next compressed bytes
+ * @param data
+ *      destination buffer
+ * @param size
+ *      maximum number of bytes to read
+ * @return
+ *      number of bytes read, 0 on end of file, -1 on error
+ */
+ssize_t BtSnoopDecompressSource::read_input(char * data,size_t size){
+
+	ssize_t count;
+
+	do {
+		count = pread(fd, data, size, input_position);
+	} while (count == -1 && errno == EINTR);
+
+	if (count > 0){
+		input_position += count;
+	}
+	return count;
+}
+
+/**
+ * @brief
+ *      give a decompressed chunk to reader (wait if queue is full)
+ * @param chunk
+ *      decompressed data (swapped with a recycled chunk)
+ * @return
+ *      false if source is being closed
+ */
+bool BtSnoopDecompressSource::push_chunk(std::vector<char> &chunk){
+
+	pthread_mutex_lock(&lock);
+
+	while (chunks.size() >= DECOMPRESS_QUEUE_DEPTH && !stopped){
+		pthread_cond_wait(&cond, &lock);
+	}
+
+	if (stopped){
+		pthread_mutex_unlock(&lock);
+		return false;
+	}
+
+	chunks.push_back(std::vector<char>());
+	chunks.back().swap(chunk);
+
+	if (!free_chunks.empty()){
+		chunk.swap(free_chunks.back());
+		free_chunks.pop_back();
+	}
+
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&lock);
+
+	return true;
+}
+
+/**
+ * @brief
+ *      decompress gzip file (one or more gzip members)
+ * @return
+ *      success status
+ */
+bool BtSnoopDecompressSource::inflate_gzip(){
+
+	#ifdef BTSNOOP_ZLIB
+
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+
+	//15 window bits + 32 : gzip/zlib header detection
+	if (inflateInit2(&stream, 15 + 32) != Z_OK){
+		return false;
+	}
+
+	std::vector<char> input(DECOMPRESS_INPUT_SIZE);
+	std::vector<char> chunk;
+	bool success = true;
+	bool member_ended = false;
+	bool input_ended = false;
+
+	while (true){
+
+		if (stream.avail_in == 0 && !input_ended){
+
+			ssize_t count = read_input(&input[0], input.size());
+
+			if (count < 0){
+				success = false;
+				break;
+			}
+			if (count == 0){
+				input_ended = true;
+			}
+			else{
+				stream.next_in = (Bytef *)&input[0];
+				stream.avail_in = count;
+			}
+		}
+
+		chunk.resize(DECOMPRESS_CHUNK_SIZE);
+		stream.next_out = (Bytef *)&chunk[0];
+		stream.avail_out = chunk.size();
+
+		int ret = inflate(&stream, Z_NO_FLUSH);
+
+		if (ret == Z_STREAM_END){
+			//concatenated gzip members
+			inflateReset(&stream);
+			member_ended = true;
+		}
+		else if (ret == Z_OK){
+			member_ended = false;
+		}
+		else if (ret != Z_BUF_ERROR){
+			//garbage after a complete member (padding) ends the file
+			success = member_ended;
+			break;
+		}
+
+		chunk.resize(DECOMPRESS_CHUNK_SIZE - stream.avail_out);
+
+		if (!chunk.empty() && !push_chunk(chunk)){
+			break;
+		}
+
+		//end of file : output still buffered in inflate is flushed first, then last
+		//member must have ended (a truncated file has no trailer)
+		if (input_ended && chunk.empty()){
+			success = member_ended;
+			break;
+		}
+	}
+
+	inflateEnd(&stream);
+
+	return success;
+
+	#else
+	return false;
+	#endif // BTSNOOP_ZLIB
+}
+
+/**
+ * @brief
+ *      decompress zstd file (one or more zstd frames)
+ * @return
+ *      success status
+ */
+bool BtSnoopDecompressSource::inflate_zstd(){
+
+	#ifdef BTSNOOP_ZSTD
+
+	ZSTD_DStream * stream = ZSTD_createDStream();
+
+	if (stream == NULL){
+		return false;
+	}
+
+	ZSTD_initDStream(stream);
+
+	std::vector<char> input(DECOMPRESS_INPUT_SIZE);
+	std::vector<char> chunk;
+	bool success = true;
+
+	ZSTD_inBuffer in_buffer;
+	in_buffer.src = &input[0];
+	in_buffer.size = 0;
+	in_buffer.pos = 0;
+
+	bool input_ended = false;
+	bool frame_ended = false;
+
+	while (true){
+
+		if (in_buffer.pos == in_buffer.size && !input_ended){
+
+			ssize_t count = read_input(&input[0], input.size());
+
+			if (count < 0){
+				success = false;
+				break;
+			}
+			if (count == 0){
+				input_ended = true;
+			}
+			else{
+				in_buffer.size = count;
+				in_buffer.pos = 0;
+			}
+		}
+
+		chunk.resize(DECOMPRESS_CHUNK_SIZE);
+
+		ZSTD_outBuffer out_buffer;
+		out_buffer.dst = &chunk[0];
+		out_buffer.size = chunk.size();
+		out_buffer.pos = 0;
+
+		size_t in_position = in_buffer.pos;
+		size_t ret = ZSTD_decompressStream(stream, &out_buffer, &in_buffer);
+
+		if (ZSTD_isError(ret)){
+			success = false;
+			break;
+		}
+
+		//0 is returned once a frame is fully decoded and flushed (concatenated frames)
+		if (ret == 0){
+			frame_ended = true;
+		}
+		else if (in_buffer.pos != in_position || out_buffer.pos > 0){
+			frame_ended = false;
+		}
+
+		chunk.resize(out_buffer.pos);
+
+		if (!chunk.empty() && !push_chunk(chunk)){
+			break;
+		}
+
+		//end of file : decompression goes on until output buffered in zstd is flushed,
+		//then last frame must be complete
+		if (input_ended && out_buffer.pos < out_buffer.size){
+			success = frame_ended;
+			break;
+		}
+	}
+
+	ZSTD_freeDStream(stream);
+
+	return success;
+
+	#else
+	return false;
+	#endif // BTSNOOP_ZSTD
+}
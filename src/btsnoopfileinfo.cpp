@@ -31,6 +31,7 @@
 */
 
 #include "btsnoop/btsnoopfileinfo.h"
+#include "btsnoop/btsnoopendian.h"
 #include "iostream"
 
 using namespace std;
@@ -48,25 +49,17 @@ BtSnoopFileInfo::BtSnoopFileInfo(){
  * @param data
  *      file header data of size 16 (16 octet => 8 + 4 + 4)
  */
-BtSnoopFileInfo::BtSnoopFileInfo(char* data){
+BtSnoopFileInfo::BtSnoopFileInfo(const char* data){
 
 	identification_number=std::string(data,data+8);
 
-	version_number=0;
+	version_number=btsnoop_read_be32(data + 8);
 
-	for (int i = 8;i<12;i++){
-		version_number+=((data[i] & 0xFF) << (3-(i-8))*8);
-	}
-
-	unsigned int datalink_num = 0;
+	unsigned int datalink_num = btsnoop_read_be32(data + 12);
 
 	datalink=UNKNOWN;
 	datalakink_str="";
 
-	for (int i = 12;i<16;i++){
-		datalink_num+=((data[i] & 0xFF) << ((3-(i-12)))*8);
-	}
-
 	switch (datalink_num){
 
 		case IEEE_802_3:
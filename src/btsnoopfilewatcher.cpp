@@ -0,0 +1,379 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopfilewatcher.cpp
+
+	Wait for changes on a streamed btsnoop file (inotify with polling fallback)
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnoopfilewatcher.h"
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+//polling interval bounds (milliseconds) when inotify is not available
+#define WATCH_MIN_POLL_INTERVAL 5
+#define WATCH_MAX_POLL_INTERVAL 200
+
+//file systems which dont report remote modifications through inotify
+#define WATCH_NFS_SUPER_MAGIC  0x6969
+#define WATCH_SMB_SUPER_MAGIC  0x517B
+#define WATCH_CIFS_SUPER_MAGIC 0xFF534D42
+#define WATCH_FUSE_SUPER_MAGIC 0x65735546
+
+BtSnoopFileWatcher::BtSnoopFileWatcher(){
+	inotify_fd = -1;
+	watch_fd = -1;
+	wakeup_pipe[0] = -1;
+	wakeup_pipe[1] = -1;
+	poll_interval = WATCH_MIN_POLL_INTERVAL;
+	last_inode = 0;
+	last_size = 0;
+	last_mtime.tv_sec = 0;
+	last_mtime.tv_nsec = 0;
+	pthread_mutex_init(&lock, NULL);
+}
+
+/**
+ * @brief
+ *      watch state is not copied : copy is a closed watcher
+ */
+BtSnoopFileWatcher::BtSnoopFileWatcher(const BtSnoopFileWatcher&){
+	inotify_fd = -1;
+	watch_fd = -1;
+	wakeup_pipe[0] = -1;
+	wakeup_pipe[1] = -1;
+	poll_interval = WATCH_MIN_POLL_INTERVAL;
+	last_inode = 0;
+	last_size = 0;
+	last_mtime.tv_sec = 0;
+	last_mtime.tv_nsec = 0;
+	pthread_mutex_init(&lock, NULL);
+}
+
+BtSnoopFileWatcher& BtSnoopFileWatcher::operator=(const BtSnoopFileWatcher& other){
+	if (this != &other){
+		close();
+	}
+	return *this;
+}
+
+BtSnoopFileWatcher::~BtSnoopFileWatcher(){
+	close();
+	pthread_mutex_destroy(&lock);
+}
+
+/**
+ * @brief
+ *      start watching file (inotify if supported by file system, adaptive polling otherwise)
+ * @param file_path
+ *      btsnoop file path
+ * @return
+ *      success status
+ */
+bool BtSnoopFileWatcher::open(std::string file_path){
+
+	close();
+
+	this->file_path = file_path;
+	poll_interval = WATCH_MIN_POLL_INTERVAL;
+
+	pthread_mutex_lock(&lock);
+	int rc = pipe2(wakeup_pipe, O_NONBLOCK | O_CLOEXEC);
+	pthread_mutex_unlock(&lock);
+
+	if (rc == -1){
+		wakeup_pipe[0] = -1;
+		wakeup_pipe[1] = -1;
+		return false;
+	}
+
+	struct stat file_stat;
+
+	if (stat(file_path.c_str(), &file_stat) == 0){
+		last_inode = file_stat.st_ino;
+		last_size = file_stat.st_size;
+		last_mtime = file_stat.st_mtim;
+	}
+
+	struct statfs fs_stat;
+
+	if (statfs(file_path.c_str(), &fs_stat) == 0){
+
+		switch ((unsigned int)fs_stat.f_type){
+			case WATCH_NFS_SUPER_MAGIC:
+			case WATCH_SMB_SUPER_MAGIC:
+			case WATCH_CIFS_SUPER_MAGIC:
+			case WATCH_FUSE_SUPER_MAGIC:
+				return true;
+		}
+	}
+
+	inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (inotify_fd != -1 && !add_watch() && errno != ENOENT){
+		//inotify exists but cant watch this file : use polling
+		::close(inotify_fd);
+		inotify_fd = -1;
+	}
+
+	return true;
+}
+
+/**
+ * @brief
+ *      stop watching file
+ */
+void BtSnoopFileWatcher::close(){
+
+	pthread_mutex_lock(&lock);
+
+	if (inotify_fd != -1){
+		::close(inotify_fd);
+		inotify_fd = -1;
+	}
+	watch_fd = -1;
+
+	for (int i = 0; i < 2;i++){
+		if (wakeup_pipe[i] != -1){
+			::close(wakeup_pipe[i]);
+			wakeup_pipe[i] = -1;
+		}
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+/**
+ * @brief
+ *      define if file changes are notified by inotify (false when polling)
+ * @return
+ */
+bool BtSnoopFileWatcher::is_event_driven(){
+	return inotify_fd != -1;
+}
+
+/**
+ * @brief
+ *      interrupt a pending wait() (may be called from any thread)
+ */
+void BtSnoopFileWatcher::wakeup(){
+
+	pthread_mutex_lock(&lock);
+
+	if (wakeup_pipe[1] != -1){
+		char value = 1;
+		ssize_t rc = write(wakeup_pipe[1], &value, 1);
+		(void)rc;
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+/**
+ * @brief
+ *      (re)register inotify watch on file path
+ * @return
+ *      success status
+ */
+bool BtSnoopFileWatcher::add_watch(){
+
+	//IN_ATTRIB is notified on unlink : IN_DELETE_SELF only comes when file is no longer opened
+	watch_fd = inotify_add_watch(inotify_fd, file_path.c_str(), IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+
+	struct stat file_stat;
+
+	if (watch_fd != -1 && stat(file_path.c_str(), &file_stat) == 0){
+		last_inode = file_stat.st_ino;
+	}
+
+	return watch_fd != -1;
+}
+
+/**
+ * @brief
+ *      block until watched file changes or wakeup() is called
+ * @return
+ *      mask of watch_event
+ */
+int BtSnoopFileWatcher::wait(){
+
+	if (wakeup_pipe[0] == -1){
+		return WATCH_WAKEUP;
+	}
+
+	if (inotify_fd != -1){
+		return wait_event();
+	}
+	return wait_polling();
+}
+
+/**
+ * @brief
+ *      wait with inotify events
+ */
+int BtSnoopFileWatcher::wait_event(){
+
+	int timeout = -1;
+
+	if (watch_fd == -1){
+
+		//file has been moved or deleted : watch the new file as soon as it is created
+		if (add_watch()){
+			return WATCH_MODIFIED;
+		}
+		timeout = WATCH_MAX_POLL_INTERVAL;
+	}
+
+	struct pollfd fds[2];
+	fds[0].fd = inotify_fd;
+	fds[0].events = POLLIN;
+	fds[1].fd = wakeup_pipe[0];
+	fds[1].events = POLLIN;
+
+	if (poll(fds, 2, timeout) <= 0){
+		return WATCH_TIMEOUT;
+	}
+
+	int events = WATCH_TIMEOUT;
+
+	if (fds[1].revents & POLLIN){
+
+		char buffer[64];
+		while (read(wakeup_pipe[0], buffer, sizeof(buffer)) > 0);
+
+		events |= WATCH_WAKEUP;
+	}
+
+	if (fds[0].revents & POLLIN){
+
+		char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+		ssize_t length;
+
+		while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0){
+
+			for (char * ptr = buffer; ptr < buffer + length; ptr += sizeof(struct inotify_event) + ((struct inotify_event *)ptr)->len){
+
+				const struct inotify_event * event = (const struct inotify_event *)ptr;
+
+				if (event->wd != watch_fd){
+					continue;
+				}
+
+				if (event->mask & IN_MODIFY){
+					events |= WATCH_MODIFIED;
+				}
+				if (event->mask & IN_MOVE_SELF){
+					events |= WATCH_MOVED;
+					//watch follows the moved inode : watch the path again instead
+					inotify_rm_watch(inotify_fd, watch_fd);
+					watch_fd = -1;
+				}
+				if (event->mask & IN_ATTRIB){
+
+					struct stat file_stat;
+
+					//file unlinked or replaced at file path : watch the path again
+					if (stat(file_path.c_str(), &file_stat) == -1 || file_stat.st_ino != last_inode){
+						events |= WATCH_DELETED;
+						inotify_rm_watch(inotify_fd, watch_fd);
+						watch_fd = -1;
+					}
+				}
+				if (event->mask & IN_DELETE_SELF){
+					events |= WATCH_DELETED;
+				}
+				if (event->mask & IN_IGNORED){
+					watch_fd = -1;
+				}
+			}
+		}
+	}
+	return events;
+}
+
+/**
+ * @brief
+ *      wait with stat polling, interval grows while file is idle
+ */
+int BtSnoopFileWatcher::wait_polling(){
+
+	struct pollfd fd;
+	fd.fd = wakeup_pipe[0];
+	fd.events = POLLIN;
+
+	if (poll(&fd, 1, poll_interval) > 0 && (fd.revents & POLLIN)){
+
+		char buffer[64];
+		while (read(wakeup_pipe[0], buffer, sizeof(buffer)) > 0);
+
+		return WATCH_WAKEUP;
+	}
+
+	int events = WATCH_TIMEOUT;
+
+	struct stat file_stat;
+
+	if (stat(file_path.c_str(), &file_stat) == -1){
+
+		if (last_inode != 0){
+			events |= WATCH_DELETED;
+		}
+		last_inode = 0;
+		last_size = 0;
+	}
+	else{
+
+		if (last_inode != 0 && file_stat.st_ino != last_inode){
+			events |= WATCH_MOVED;
+		}
+
+		if (file_stat.st_ino != last_inode ||
+			file_stat.st_size != last_size ||
+			file_stat.st_mtim.tv_sec != last_mtime.tv_sec ||
+			file_stat.st_mtim.tv_nsec != last_mtime.tv_nsec){
+			events |= WATCH_MODIFIED;
+		}
+
+		last_inode = file_stat.st_ino;
+		last_size = file_stat.st_size;
+		last_mtime = file_stat.st_mtim;
+	}
+
+	if (events != WATCH_TIMEOUT){
+		poll_interval = WATCH_MIN_POLL_INTERVAL;
+	}
+	else if (poll_interval < WATCH_MAX_POLL_INTERVAL){
+		poll_interval = (poll_interval * 2 > WATCH_MAX_POLL_INTERVAL) ? WATCH_MAX_POLL_INTERVAL : poll_interval * 2;
+	}
+
+	return events;
+}
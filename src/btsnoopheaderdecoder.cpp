@@ -0,0 +1,197 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopheaderdecoder.cpp
+
+	Batch decoding of consecutive packet record headers into columns. SSSE3
+	shuffles are used when supported by the cpu, scalar byte swaps otherwise
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnoopheaderdecoder.h"
+#include "btsnoop/btsnoopendian.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BTSNOOP_HEADER_SSSE3
+#include <tmmintrin.h>
+#endif
+
+/**
+ * @brief
+ *      decode headers of complete packet records at the beginning of a buffer
+ *      (scalar version)
+ */
+size_t BtSnoopHeaderDecoder::decode_scalar(const char * data,size_t size,size_t max_count,const BtSnoopHeaderColumns &columns,size_t &consumed){
+
+	size_t offset = 0;
+	size_t count = 0;
+
+	while (count < max_count && size - offset >= 24) {
+
+		const char * header = data + offset;
+
+		uint32_t included_length = btsnoop_read_be32(header + 4);
+
+		//incomplete trailing record
+		if ((uint64_t)included_length > size - offset - 24){
+			break;
+		}
+
+		if (columns.offsets != 0){
+			columns.offsets[count] = offset;
+		}
+		if (columns.original_lengths != 0){
+			columns.original_lengths[count] = btsnoop_read_be32(header);
+		}
+		if (columns.included_lengths != 0){
+			columns.included_lengths[count] = included_length;
+		}
+		if (columns.flags != 0){
+			columns.flags[count] = (uint8_t)header[11];
+		}
+		if (columns.cumulative_drops != 0){
+			columns.cumulative_drops[count] = btsnoop_read_be32(header + 12);
+		}
+		if (columns.timestamps != 0){
+			columns.timestamps[count] = btsnoop_read_be64(header + 16);
+		}
+
+		offset += 24 + included_length;
+		count++;
+	}
+
+	consumed = offset;
+
+	return count;
+}
+
+#ifdef BTSNOOP_HEADER_SSSE3
+
+/**
+ * @brief
+ *      decode headers of complete packet records : the four 32 bit fields are
+ *      byte swapped with one shuffle, timestamp with a second one
+ */
+__attribute__((target("ssse3")))
+static size_t decode_ssse3(const char * data,size_t size,size_t max_count,const BtSnoopHeaderColumns &columns,size_t &consumed){
+
+	//reverse bytes of each 32 bit lane
+	const __m128i swap32 = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+	//reverse bytes of low 64 bit lane
+	const __m128i swap64 = _mm_set_epi8(15, 14, 13, 12, 11, 10, 9, 8, 0, 1, 2, 3, 4, 5, 6, 7);
+
+	size_t offset = 0;
+	size_t count = 0;
+
+	uint32_t fields[4] __attribute__ ((aligned(16)));
+
+	while (count < max_count && size - offset >= 24) {
+
+		const char * header = data + offset;
+
+		__m128i lanes = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)header), swap32);
+
+		_mm_store_si128((__m128i *)fields, lanes);
+
+		uint32_t included_length = fields[1];
+
+		//incomplete trailing record
+		if ((uint64_t)included_length > size - offset - 24){
+			break;
+		}
+
+		if (columns.offsets != 0){
+			columns.offsets[count] = offset;
+		}
+		if (columns.original_lengths != 0){
+			columns.original_lengths[count] = fields[0];
+		}
+		if (columns.included_lengths != 0){
+			columns.included_lengths[count] = included_length;
+		}
+		if (columns.flags != 0){
+			columns.flags[count] = (uint8_t)fields[2];
+		}
+		if (columns.cumulative_drops != 0){
+			columns.cumulative_drops[count] = fields[3];
+		}
+		if (columns.timestamps != 0){
+			__m128i timestamp = _mm_shuffle_epi8(_mm_loadl_epi64((const __m128i *)(header + 16)), swap64);
+			_mm_storel_epi64((__m128i *)(columns.timestamps + count), timestamp);
+		}
+
+		offset += 24 + included_length;
+		count++;
+	}
+
+	consumed = offset;
+
+	return count;
+}
+
+#endif // BTSNOOP_HEADER_SSSE3
+
+/**
+ * @brief
+ *      decode headers of complete packet records at the beginning of a buffer
+ * @param data
+ *      buffer starting with a packet record
+ * @param size
+ *      buffer size
+ * @param max_count
+ *      maximum number of records to decode (size of each column)
+ * @param columns
+ *      output columns
+ * @param consumed
+ *      number of bytes used by decoded records
+ * @return
+ *      number of decoded records
+ */
+size_t BtSnoopHeaderDecoder::decode(const char * data,size_t size,size_t max_count,const BtSnoopHeaderColumns &columns,size_t &consumed){
+
+	#ifdef BTSNOOP_HEADER_SSSE3
+	if (is_simd_supported()){
+		return decode_ssse3(data, size, max_count, columns, consumed);
+	}
+	#endif // BTSNOOP_HEADER_SSSE3
+
+	return decode_scalar(data, size, max_count, columns, consumed);
+}
+
+/**
+ * @brief
+ *      define if decode() uses SIMD instructions on this cpu
+ * @return
+ */
+bool BtSnoopHeaderDecoder::is_simd_supported(){
+
+	#ifdef BTSNOOP_HEADER_SSSE3
+	static const bool supported = __builtin_cpu_supports("ssse3");
+	return supported;
+	#else
+	return false;
+	#endif // BTSNOOP_HEADER_SSSE3
+}
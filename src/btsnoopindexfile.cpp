@@ -0,0 +1,423 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopindexfile.cpp
+
+	Persistent sidecar index of a btsnoop file (<file>.idx) : start offset and
+	timestamp of each packet record. Index is validated against size, modification
+	time and header of the btsnoop file and only records appended since last save
+	are indexed
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnoopindexfile.h"
+#include "algorithm"
+#include "btsnoop/btsnoopheaderdecoder.h"
+#include "btsnoop/btsnoopendian.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+
+//magic bytes of sidecar index
+static const char INDEX_FILE_MAGIC[8] = {'B','T','S','N','P','I','D','X'};
+
+/**
+ * @brief
+ *      write a whole buffer at a file position
+ * @return
+ *      success status
+ */
+static bool write_at(int fd,const void * data,size_t size,int64_t position){
+
+	const char * ptr = (const char*)data;
+
+	while (size > 0){
+
+		ssize_t written = pwrite(fd, ptr, size, position);
+
+		if (written <= 0){
+			return false;
+		}
+		ptr += written;
+		size -= written;
+		position += written;
+	}
+	return true;
+}
+
+BtSnoopIndexFile::BtSnoopIndexFile(){
+	reset();
+}
+
+BtSnoopIndexFile::BtSnoopIndexFile(const BtSnoopIndexFile&){
+	reset();
+}
+
+BtSnoopIndexFile& BtSnoopIndexFile::operator=(const BtSnoopIndexFile& index_file){
+	if (this != &index_file){
+		index_path.clear();
+		reset();
+	}
+	return *this;
+}
+
+/**
+ * @brief
+ *      discard loaded index : btsnoop file is indexed from its header
+ */
+void BtSnoopIndexFile::reset(){
+
+	mapping.close();
+	mapped_entries = 0;
+	mapped_count = 0;
+	offsets.clear();
+	timestamps.clear();
+	modified = true;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, INDEX_FILE_MAGIC, 8);
+	header.version = INDEX_FILE_VERSION;
+	header.entry_size = sizeof(BtSnoopIndexEntry);
+}
+
+/**
+ * @brief
+ *      load sidecar index of a btsnoop file (memory mapped). Index not matching
+ *      btsnoop file (other header, truncated file, last indexed record changed) is
+ *      discarded
+ * @param index_path
+ *      sidecar index path
+ * @param fd
+ *      btsnoop file descriptor
+ * @return
+ *      true if existing index is used
+ */
+bool BtSnoopIndexFile::load(std::string index_path,int fd){
+
+	reset();
+	this->index_path = index_path;
+
+	if (!mapping.open(index_path) || mapping.size() < sizeof(BtSnoopIndexHeader)){
+		reset();
+		return false;
+	}
+
+	BtSnoopIndexHeader loaded;
+	memcpy(&loaded, mapping.data(), sizeof(loaded));
+
+	//entry size also rejects an index written with another byte order
+	if (memcmp(loaded.magic, INDEX_FILE_MAGIC, 8) != 0 ||
+		loaded.version != INDEX_FILE_VERSION ||
+		loaded.entry_size != sizeof(BtSnoopIndexEntry) ||
+		loaded.record_count > (mapping.size() - sizeof(BtSnoopIndexHeader)) / sizeof(BtSnoopIndexEntry)){
+		reset();
+		return false;
+	}
+
+	header = loaded;
+	mapped_entries = (const BtSnoopIndexEntry*)(mapping.data() + sizeof(BtSnoopIndexHeader));
+	mapped_count = loaded.record_count;
+
+	if (!validate(fd)){
+		reset();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief
+ *      check loaded index against btsnoop file
+ * @param fd
+ *      btsnoop file descriptor
+ * @return
+ *      true if index matches btsnoop file
+ */
+bool BtSnoopIndexFile::validate(int fd){
+
+	struct stat file_stat;
+	char file_header[16];
+
+	if (fstat(fd, &file_stat) == -1 || pread(fd, file_header, 16, 0) != 16){
+		return false;
+	}
+
+	if (memcmp(file_header, header.capture_header, 16) != 0 || file_stat.st_size < header.indexed_end){
+		return false;
+	}
+
+	if (file_stat.st_size == header.capture_size &&
+		file_stat.st_mtim.tv_sec == header.capture_mtime_sec &&
+		file_stat.st_mtim.tv_nsec == header.capture_mtime_nsec){
+		modified = false;
+		return true;
+	}
+
+	//file has changed : last indexed record must still end at indexed position
+	if (mapped_count == 0){
+		return header.indexed_end == 16;
+	}
+
+	const BtSnoopIndexEntry &last = mapped_entries[mapped_count - 1];
+	char record_header[24];
+
+	if (pread(fd, record_header, 24, last.offset) != 24){
+		return false;
+	}
+
+	return btsnoop_read_be64(record_header + 16) == last.timestamp &&
+		last.offset + 24 + (int64_t)btsnoop_read_be32(record_header + 4) == header.indexed_end;
+}
+
+/**
+ * @brief
+ *      index packet records appended to btsnoop file since last indexed record
+ * @param fd
+ *      btsnoop file descriptor
+ * @return
+ *      number of new records
+ */
+size_t BtSnoopIndexFile::update(int fd){
+
+	struct stat file_stat;
+
+	if (fstat(fd, &file_stat) == -1){
+		return 0;
+	}
+
+	if (header.indexed_end == 0){
+
+		if (pread(fd, header.capture_header, 16, 0) != 16){
+			return 0;
+		}
+		header.indexed_end = 16;
+	}
+
+	std::vector<char> buffer(INDEX_READ_SIZE);
+
+	size_t max_count = INDEX_READ_SIZE / 24;
+
+	std::vector<size_t> record_offsets(max_count);
+	std::vector<uint32_t> included_lengths(max_count);
+	std::vector<uint64_t> record_timestamps(max_count);
+
+	BtSnoopHeaderColumns columns;
+	columns.offsets = &record_offsets[0];
+	columns.original_lengths = 0;
+	columns.included_lengths = &included_lengths[0];
+	columns.flags = 0;
+	columns.cumulative_drops = 0;
+	columns.timestamps = &record_timestamps[0];
+
+	int64_t position = header.indexed_end;
+	size_t first = offsets.size();
+
+	while (position < file_stat.st_size){
+
+		ssize_t length = pread(fd, &buffer[0], buffer.size(), position);
+
+		if (length <= 0){
+			break;
+		}
+
+		size_t consumed = 0;
+		size_t count = BtSnoopHeaderDecoder::decode(&buffer[0], length, max_count, columns, consumed);
+
+		for (size_t i = 0; i < count;i++){
+			this->offsets.push_back(position + record_offsets[i]);
+			this->timestamps.push_back((int64_t)record_timestamps[i]);
+		}
+
+		if (count == 0){
+
+			//incomplete record at end of file
+			if ((size_t)length < buffer.size() || length < 24){
+				break;
+			}
+
+			int64_t record_size = 24 + (int64_t)btsnoop_read_be32(&buffer[4]);
+
+			if (record_size > file_stat.st_size - position){
+				break;
+			}
+			//record bigger than read buffer
+			buffer.resize(record_size);
+		}
+		position += consumed;
+	}
+
+	header.indexed_end = position;
+
+	if (offsets.size() > first ||
+		header.capture_size != file_stat.st_size ||
+		header.capture_mtime_sec != file_stat.st_mtim.tv_sec ||
+		header.capture_mtime_nsec != file_stat.st_mtim.tv_nsec){
+		modified = true;
+	}
+
+	header.capture_size = file_stat.st_size;
+	header.capture_mtime_sec = file_stat.st_mtim.tv_sec;
+	header.capture_mtime_nsec = file_stat.st_mtim.tv_nsec;
+	header.record_count = size();
+
+	return offsets.size() - first;
+}
+
+/**
+ * @brief
+ *      write index (only new records are written if loaded index was valid)
+ * @return
+ *      success status
+ */
+bool BtSnoopIndexFile::save(){
+
+	if (!modified){
+		return true;
+	}
+
+	header.record_count = size();
+
+	if (mapped_entries != 0){
+
+		//records are appended before header is updated : an interrupted save keeps previous index
+		int fd = open(index_path.c_str(), O_WRONLY | O_CLOEXEC);
+
+		if (fd == -1){
+			return false;
+		}
+
+		bool success = write_entries(fd, sizeof(BtSnoopIndexHeader) + mapped_count * sizeof(BtSnoopIndexEntry)) &&
+			write_at(fd, &header, sizeof(header), 0);
+
+		close(fd);
+		modified = !success;
+		return success;
+	}
+
+	//new index is written next to the previous one and renamed
+	std::string temporary_path = index_path + ".tmp";
+
+	int fd = open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+	if (fd == -1){
+		return false;
+	}
+
+	bool success = write_at(fd, &header, sizeof(header), 0) &&
+		write_entries(fd, sizeof(BtSnoopIndexHeader));
+
+	close(fd);
+
+	if (!success || rename(temporary_path.c_str(), index_path.c_str()) != 0){
+		unlink(temporary_path.c_str());
+		return false;
+	}
+	modified = false;
+	return true;
+}
+
+/**
+ * @brief
+ *      write records indexed since index was loaded
+ * @param fd
+ *      sidecar index file descriptor
+ * @param position
+ *      position of first written record in sidecar index
+ * @return
+ *      success status
+ */
+bool BtSnoopIndexFile::write_entries(int fd,int64_t position) const{
+
+	std::vector<BtSnoopIndexEntry> entries;
+	entries.reserve(std::min(offsets.size(), (size_t)(INDEX_READ_SIZE / sizeof(BtSnoopIndexEntry))));
+
+	//sidecar records are 64 bit : written by chunks of INDEX_READ_SIZE
+	for (size_t i = 0; i < offsets.size();i++){
+
+		BtSnoopIndexEntry indexed;
+		indexed.offset = offsets.get(i);
+		indexed.timestamp = (uint64_t)timestamps.get(i);
+		entries.push_back(indexed);
+
+		if (entries.size() == entries.capacity() || i + 1 == offsets.size()){
+
+			if (!write_at(fd, &entries[0], entries.size() * sizeof(BtSnoopIndexEntry), position)){
+				return false;
+			}
+			position += entries.size() * sizeof(BtSnoopIndexEntry);
+			entries.clear();
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief
+ *      get number of indexed packet records
+ * @return
+ */
+size_t BtSnoopIndexFile::size() const{
+	return mapped_count + offsets.size();
+}
+
+/**
+ * @brief
+ *      get position of a packet record in btsnoop file
+ * @param index
+ *      record index (< size())
+ * @return
+ */
+int64_t BtSnoopIndexFile::getOffset(size_t index) const{
+	if (index < mapped_count){
+		return mapped_entries[index].offset;
+	}
+	return offsets.get(index - mapped_count);
+}
+
+/**
+ * @brief
+ *      get btsnoop timestamp of a packet record
+ * @param index
+ *      record index (< size())
+ * @return
+ */
+uint64_t BtSnoopIndexFile::getTimestamp(size_t index) const{
+	if (index < mapped_count){
+		return mapped_entries[index].timestamp;
+	}
+	return (uint64_t)timestamps.get(index - mapped_count);
+}
+
+/**
+ * @brief
+ *      get position after last indexed packet record
+ * @return
+ */
+int64_t BtSnoopIndexFile::getIndexedEnd() const{
+	return header.indexed_end;
+}
@@ -0,0 +1,74 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooplisteneradapter.cpp
+
+	Deliver packet records to a legacy IBtSnoopListener through the record listener interface
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnooplisteneradapter.h"
+
+/**
+ * @brief
+ *      build adapter
+ * @param listener
+ *      legacy listener (not owned)
+ */
+BtSnoopListenerAdapter::BtSnoopListenerAdapter(IBtSnoopListener * listener){
+	this->listener = listener;
+}
+
+#ifdef __ANDROID__
+
+void BtSnoopListenerAdapter::onSnoopPacket(const BtSnoopFileInfo &fileInfo,const BtSnoopPacketView &record,JNIEnv * jni_env){
+	listener->onSnoopPacketReceived(fileInfo,record.toPacket(),jni_env);
+}
+
+void BtSnoopListenerAdapter::onFinishedCountingPackets(int packet_count,JNIEnv * jni_env){
+	listener->onFinishedCountingPackets(packet_count,jni_env);
+}
+
+void BtSnoopListenerAdapter::onError(int error_code,const std::string &error_message,JNIEnv * jni_env){
+	listener->onError(error_code,error_message,jni_env);
+}
+
+#else
+
+void BtSnoopListenerAdapter::onSnoopPacket(const BtSnoopFileInfo &fileInfo,const BtSnoopPacketView &record){
+	//legacy listener receives a packet copy (views are only given to record listeners)
+	listener->onSnoopPacketReceived(fileInfo,record.toPacket());
+}
+
+void BtSnoopListenerAdapter::onFinishedCountingPackets(int packet_count){
+	listener->onFinishedCountingPackets(packet_count);
+}
+
+void BtSnoopListenerAdapter::onError(int error_code,const std::string &error_message){
+	listener->onError(error_code,error_message);
+}
+
+#endif //__ANDROID__
@@ -0,0 +1,139 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopmappedfile.cpp
+
+	Read-only memory mapping of a whole btsnoop file
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnoopmappedfile.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+
+BtSnoopMappedFile::BtSnoopMappedFile(){
+	fd = -1;
+	mapping = 0;
+	mapping_size = 0;
+}
+
+/**
+ * @brief
+ *      unmap file and close descriptor
+ */
+BtSnoopMappedFile::~BtSnoopMappedFile(){
+	close();
+}
+
+/**
+ * @brief
+ *      map the whole file in memory (read only)
+ * @param file_path
+ *      btsnoop file path
+ * @return
+ *      success status
+ */
+bool BtSnoopMappedFile::open(std::string file_path){
+
+	close();
+
+	fd = ::open(file_path.c_str(), O_RDONLY);
+
+	if (fd == -1){
+		return false;
+	}
+
+	struct stat file_stat;
+
+	if (fstat(fd, &file_stat) == -1 || file_stat.st_size <= 0){
+		close();
+		return false;
+	}
+
+	//whole file must fit in address space (32 bit builds)
+	if ((uint64_t)file_stat.st_size > (uint64_t)SIZE_MAX){
+		close();
+		return false;
+	}
+
+	mapping_size = file_stat.st_size;
+
+	void * addr = mmap(0, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	if (addr == MAP_FAILED){
+		mapping_size = 0;
+		close();
+		return false;
+	}
+
+	mapping = (char*)addr;
+
+	//records are walked front to back exactly once
+	madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+
+	return true;
+}
+
+/**
+ * @brief
+ *      release current mapping
+ */
+void BtSnoopMappedFile::close(){
+
+	if (mapping != 0){
+		munmap(mapping, mapping_size);
+		mapping = 0;
+	}
+	mapping_size = 0;
+
+	if (fd != -1){
+		::close(fd);
+		fd = -1;
+	}
+}
+
+/**
+ * @brief
+ *      get pointer to the first byte of the mapping
+ * @return
+ *      mapped data (0 if nothing is mapped)
+ */
+const char * BtSnoopMappedFile::data() const{
+	return mapping;
+}
+
+/**
+ * @brief
+ *      get size of the mapping
+ * @return
+ *      mapped size in bytes
+ */
+size_t BtSnoopMappedFile::size() const{
+	return mapping_size;
+}
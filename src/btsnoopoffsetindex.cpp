@@ -0,0 +1,139 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopoffsetindex.cpp
+
+	Dense index of packet record positions by packet number : positions are stored
+	as 32 bit deltas from the first position of each block of records
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnoopoffsetindex.h"
+
+BtSnoopOffsetIndex::BtSnoopOffsetIndex(){
+}
+
+/**
+ * @brief
+ *      append position (or timestamp) of next packet
+ * @param value
+ *      position in file (or timestamp)
+ */
+void BtSnoopOffsetIndex::push_back(int64_t value){
+
+	size_t index = deltas.size();
+	size_t block = index / OFFSET_INDEX_BLOCK_SIZE;
+
+	if (index % OFFSET_INDEX_BLOCK_SIZE == 0){
+		bases.push_back(value);
+		wide_blocks.push_back(OFFSET_INDEX_NARROW);
+	}
+
+	int64_t delta = value - bases[block];
+
+	//records bigger than 64MB on average in a block / clock set backward : 32 bit
+	//deltas dont fit
+	if (wide_blocks[block] == OFFSET_INDEX_NARROW && (delta < 0 || delta > UINT32_MAX)){
+		widen(block);
+	}
+
+	if (wide_blocks[block] != OFFSET_INDEX_NARROW){
+		wide[(size_t)wide_blocks[block] * OFFSET_INDEX_BLOCK_SIZE + index % OFFSET_INDEX_BLOCK_SIZE] = value;
+		deltas.push_back(0);
+		return;
+	}
+	deltas.push_back((uint32_t)delta);
+}
+
+/**
+ * @brief
+ *      store values of a block as 64 bit values (a delta does not fit 32 bits)
+ * @param block
+ *      block number
+ */
+void BtSnoopOffsetIndex::widen(size_t block){
+
+	size_t start = wide.size();
+
+	wide_blocks[block] = (uint32_t)(start / OFFSET_INDEX_BLOCK_SIZE);
+	wide.resize(start + OFFSET_INDEX_BLOCK_SIZE);
+
+	for (size_t i = block * OFFSET_INDEX_BLOCK_SIZE; i < deltas.size();i++){
+		wide[start + i % OFFSET_INDEX_BLOCK_SIZE] = bases[block] + deltas[i];
+	}
+}
+
+/**
+ * @brief
+ *      get position (or timestamp) of a packet
+ * @param index
+ *      packet number (< size())
+ * @return
+ */
+int64_t BtSnoopOffsetIndex::get(size_t index) const{
+
+	size_t block = index / OFFSET_INDEX_BLOCK_SIZE;
+
+	if (wide_blocks[block] != OFFSET_INDEX_NARROW){
+		return wide[(size_t)wide_blocks[block] * OFFSET_INDEX_BLOCK_SIZE + index % OFFSET_INDEX_BLOCK_SIZE];
+	}
+	return bases[block] + deltas[index];
+}
+
+int64_t BtSnoopOffsetIndex::operator[](size_t index) const{
+	return get(index);
+}
+
+/**
+ * @brief
+ *      get number of positions
+ * @return
+ */
+size_t BtSnoopOffsetIndex::size() const{
+	return deltas.size();
+}
+
+/**
+ * @brief
+ *      remove all positions
+ */
+void BtSnoopOffsetIndex::clear(){
+	bases.clear();
+	deltas.clear();
+	wide_blocks.clear();
+	wide.clear();
+}
+
+/**
+ * @brief
+ *      get memory used by index (allocated capacity)
+ * @return
+ *      number of bytes
+ */
+size_t BtSnoopOffsetIndex::getMemoryUsage() const{
+	return bases.capacity() * sizeof(int64_t) + deltas.capacity() * sizeof(uint32_t) +
+		wide_blocks.capacity() * sizeof(uint32_t) + wide.capacity() * sizeof(int64_t);
+}
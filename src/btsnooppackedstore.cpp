@@ -0,0 +1,343 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooppackedstore.cpp
+
+	Packet record store using compact packed records : records are grouped in
+	segments holding a base timestamp and the packet data of their records
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnooppackedstore.h"
+#include "btsnoop/btsnoopendian.h"
+#include "algorithm"
+#include <string.h>
+
+BtSnoopPackedStore::BtSnoopPackedStore(){
+	count = 0;
+	removed = 0;
+}
+
+/**
+ * @brief
+ *      append a packet record (header fields and payload are copied)
+ * @param record
+ *      packet record view
+ */
+void BtSnoopPackedStore::append(const BtSnoopPacketView &record){
+
+	uint64_t timestamp = record.getTimestamp();
+	BtSnoopDataSpan payload = record.getPayload();
+
+	//packet data bigger than length field is kept truncated
+	uint32_t included_length = (uint32_t)std::min(payload.size(), (size_t)PACKED_LENGTH_MASK);
+	uint32_t original_length = (uint32_t)record.getOriginalLength();
+
+	//new segment when full or when timestamp / payload offset does not fit 32 bits
+	if (segments.empty() ||
+		segments.back().records.size() >= PACKED_SEGMENT_SIZE ||
+		timestamp < segments.back().base_timestamp ||
+		timestamp - segments.back().base_timestamp > UINT32_MAX ||
+		segments.back().payloads.size() + included_length > UINT32_MAX){
+		add_segment(timestamp);
+	}
+
+	BtSnoopPackedSegment &current = segments.back();
+
+	BtSnoopPackedRecord packed;
+	packed.timestamp_delta = (uint32_t)(timestamp - current.base_timestamp);
+	packed.payload_offset = (uint32_t)current.payloads.size();
+	packed.length_flags = included_length;
+	packed.truncated_length = original_length > included_length ? original_length - included_length : 0;
+	packed.cumulative_drops = (uint32_t)record.getCumulativeDrops();
+
+	if (record.is_packet_received()){
+		packed.length_flags |= PACKED_FLAG_RECEIVED;
+	}
+	if (record.is_command_event()){
+		packed.length_flags |= PACKED_FLAG_COMMAND_EVENT;
+	}
+
+	current.records.push_back(packed);
+	current.payloads.insert(current.payloads.end(), payload.begin(), payload.begin() + included_length);
+	count++;
+}
+
+/**
+ * @brief
+ *      start a new segment (previous segment capacity is trimmed)
+ * @param timestamp
+ *      base timestamp of new segment
+ */
+void BtSnoopPackedStore::add_segment(uint64_t timestamp){
+
+	if (!segments.empty()){
+		segments.back().payloads.shrink_to_fit();
+		segments.back().records.shrink_to_fit();
+	}
+
+	segments.push_back(BtSnoopPackedSegment());
+
+	BtSnoopPackedSegment &current = segments.back();
+	current.first_index = count;
+	current.base_timestamp = timestamp;
+	current.records.reserve(PACKED_SEGMENT_SIZE);
+}
+
+/**
+ * @brief
+ *      remove all records
+ */
+void BtSnoopPackedStore::clear(){
+	segments.clear();
+	count = 0;
+	removed = 0;
+}
+
+/**
+ * @brief
+ *      remove first record (memory of a segment is released with its last record)
+ */
+void BtSnoopPackedStore::pop_front(){
+
+	if (removed == count){
+		return;
+	}
+	removed++;
+
+	BtSnoopPackedSegment &front = segments.front();
+
+	if (removed >= front.first_index + front.records.size()){
+		segments.pop_front();
+	}
+}
+
+/**
+ * @brief
+ *      get number of records
+ * @return
+ */
+size_t BtSnoopPackedStore::size() const{
+	return count - removed;
+}
+
+/**
+ * @brief
+ *      get memory used by records and packet data (allocated capacity)
+ * @return
+ *      number of bytes
+ */
+size_t BtSnoopPackedStore::getMemoryUsage() const{
+
+	size_t usage = 0;
+
+	for (size_t i = 0; i < segments.size();i++){
+		usage += sizeof(BtSnoopPackedSegment);
+		usage += segments[i].records.capacity() * sizeof(BtSnoopPackedRecord);
+		usage += segments[i].payloads.capacity();
+	}
+	return usage;
+}
+
+/**
+ * @brief
+ *      get segment containing a record
+ * @param index
+ *      record index
+ * @param position
+ *      record position in segment
+ * @return
+ */
+const BtSnoopPackedSegment & BtSnoopPackedStore::segment(size_t index,size_t &position) const{
+
+	index += removed;
+
+	//most accesses are on last segment
+	if (index >= segments.back().first_index){
+		position = index - segments.back().first_index;
+		return segments.back();
+	}
+
+	size_t low = 0;
+	size_t high = segments.size() - 1;
+
+	//last segment with first_index <= index
+	while (high - low > 1){
+
+		size_t middle = low + (high - low) / 2;
+
+		if (segments[middle].first_index <= index){
+			low = middle;
+		}
+		else{
+			high = middle;
+		}
+	}
+	position = index - segments[low].first_index;
+	return segments[low];
+}
+
+/**
+ * @brief
+ *      get packed record
+ * @param index
+ *      record index (< size())
+ * @return
+ */
+const BtSnoopPackedRecord & BtSnoopPackedStore::getPackedRecord(size_t index) const{
+
+	size_t position = 0;
+	const BtSnoopPackedSegment &current = segment(index, position);
+
+	return current.records[position];
+}
+
+/**
+ * @brief
+ *      get btsnoop timestamp of a record (microseconds since 01/01/0 AD)
+ * @param index
+ *      record index
+ * @return
+ */
+uint64_t BtSnoopPackedStore::getTimestamp(size_t index) const{
+
+	size_t position = 0;
+	const BtSnoopPackedSegment &current = segment(index, position);
+
+	return current.base_timestamp + current.records[position].timestamp_delta;
+}
+
+/**
+ * @brief
+ *      get length of original packet (could be more than included length)
+ * @param index
+ *      record index
+ * @return
+ */
+uint32_t BtSnoopPackedStore::getOriginalLength(size_t index) const{
+
+	const BtSnoopPackedRecord &packed = getPackedRecord(index);
+
+	return (packed.length_flags & PACKED_LENGTH_MASK) + packed.truncated_length;
+}
+
+/**
+ * @brief
+ *      get packet data field length
+ * @param index
+ *      record index
+ * @return
+ */
+uint32_t BtSnoopPackedStore::getIncludedLength(size_t index) const{
+	return getPackedRecord(index).length_flags & PACKED_LENGTH_MASK;
+}
+
+/**
+ * @brief
+ *      get number of packet lost between the first record and this record
+ * @param index
+ *      record index
+ * @return
+ */
+uint32_t BtSnoopPackedStore::getCumulativeDrops(size_t index) const{
+	return getPackedRecord(index).cumulative_drops;
+}
+
+/**
+ * @brief
+ *      define if packet record is received (sent otherwise)
+ * @param index
+ *      record index
+ * @return
+ */
+bool BtSnoopPackedStore::is_packet_received(size_t index) const{
+	return (getPackedRecord(index).length_flags & PACKED_FLAG_RECEIVED) != 0;
+}
+
+/**
+ * @brief
+ *      define if packet record is command or event (data otherwise)
+ * @param index
+ *      record index
+ * @return
+ */
+bool BtSnoopPackedStore::is_command_event(size_t index) const{
+	return (getPackedRecord(index).length_flags & PACKED_FLAG_COMMAND_EVENT) != 0;
+}
+
+/**
+ * @brief
+ *      get packet data of a record without copy (valid until next append / clear)
+ * @param index
+ *      record index
+ * @return
+ */
+BtSnoopDataSpan BtSnoopPackedStore::getPayload(size_t index) const{
+
+	size_t position = 0;
+	const BtSnoopPackedSegment &current = segment(index, position);
+	const BtSnoopPackedRecord &packed = current.records[position];
+
+	size_t length = packed.length_flags & PACKED_LENGTH_MASK;
+
+	if (length == 0){
+		return BtSnoopDataSpan(0, 0);
+	}
+	return BtSnoopDataSpan(&current.payloads[packed.payload_offset], length);
+}
+
+/**
+ * @brief
+ *      build a packet owning a copy of a record
+ * @param index
+ *      record index
+ * @return
+ */
+BtSnoopPacket BtSnoopPackedStore::toPacket(size_t index) const{
+
+	const BtSnoopPackedRecord &packed = getPackedRecord(index);
+
+	uint32_t packet_flags = 0;
+
+	if ((packed.length_flags & PACKED_FLAG_RECEIVED) != 0){
+		packet_flags |= 0x01;
+	}
+	if ((packed.length_flags & PACKED_FLAG_COMMAND_EVENT) != 0){
+		packet_flags |= 0x02;
+	}
+
+	//record header is rebuilt as in btsnoop file
+	char header[24];
+	btsnoop_write_be32(header, getOriginalLength(index));
+	btsnoop_write_be32(header + 4, packed.length_flags & PACKED_LENGTH_MASK);
+	btsnoop_write_be32(header + 8, packet_flags);
+	btsnoop_write_be32(header + 12, packed.cumulative_drops);
+	btsnoop_write_be64(header + 16, getTimestamp(index));
+
+	BtSnoopPacket packet(header);
+	packet.decode_data(getPayload(index).data());
+	return packet;
+}
@@ -30,10 +30,11 @@
 	@version 0.1
 */
 #include "btsnoop/btsnooppacket.h"
+#include "btsnoop/btsnooptimestamp.h"
+#include "btsnoop/btsnoopendian.h"
 #include "iostream"
 #include "stdio.h"
 #include <inttypes.h>
-#include <stdlib.h>
 #include <json/json.h>
 
 #ifdef __ANDROID__
@@ -42,8 +43,6 @@
 
 #endif
 
-#define DATE_0AD_TO_YEAR2000 0x00E03AB44A676000
-
 using namespace std;
 
 BtSnoopPacket::BtSnoopPacket(){
@@ -55,96 +54,32 @@ BtSnoopPacket::BtSnoopPacket(){
  * @param data
  *      data of size 24 (4 + 4 + 4 + 4 + 8)
  */
-BtSnoopPacket::BtSnoopPacket(char * data){
-
-	original_length=0;
-	included_length=0;
-	cumulative_drops=0;
-	packet_received=false;
-	packet_sent=false;
-	packet_type_command_event=false;
-	packet_type_data=false;
-
-	int packet_flags = 0;
-
-	for (int i = 0;i<4;i++){
-		original_length+=((data[i] & 0xFF) << (3-(i-0))*8);
-	}
-	for (int i = 4;i<8;i++){
-		included_length+=((data[i] & 0xFF) << (3-(i-4))*8);
-	}
-	for (int i = 8;i<12;i++){
-		packet_flags+=   ((data[i] & 0xFF) << (3-(i-8))*8);
-	}
-	for (int i = 12;i<16;i++){
-		cumulative_drops+=((data[i] & 0xFF) << (3-(i-12))*8);
-	}
-
-	if ((packet_flags & 0x00000001)==1){
-		packet_received=true;
-	}
-	else{
-		packet_sent=true;
-	}
+BtSnoopPacket::BtSnoopPacket(const char * data){
 
-	if ((packet_flags & 0x00000002)==1){
-		packet_type_command_event=true;
-	}
-	else{
-		packet_type_data=true;
-	}
+	original_length=btsnoop_read_be32(data);
+	included_length=btsnoop_read_be32(data + 4);
+	flags=btsnoop_read_be32(data + 8) & (PACKET_FLAG_RECEIVED | PACKET_FLAG_COMMAND_EVENT);
+	cumulative_drops=btsnoop_read_be32(data + 12);
 
 	//this is timestamp in microseconds since 01/01/0 AD
-	uint64_t timestamp_ad=0;
-
-	for (int i = 16;i<24;i++){
-		timestamp_ad+=(((uint64_t)(data[i] & 0xFF)) << (7-(i-16))*8);
-	}
-
-	uint64_t date_between_record_date_year2000=timestamp_ad-DATE_0AD_TO_YEAR2000;
-
-	struct tm t;
-	t.tm_year = 100;
-	t.tm_mon = 0;
-	t.tm_mday = 1;
-	t.tm_hour = 0;
-	t.tm_min = 0;
-	t.tm_sec = 0;
-	t.tm_isdst=0;
-
-	//save and set TZ beforme mktime
-	char *tz;
-	tz = getenv("TZ");
-	setenv("TZ", "", 1);
-	tzset();
-
-	uint64_t timeSinceEpoch = (uint64_t)mktime(&t);
-
-	//set TZ to previous value
-	if (tz)
-		setenv("TZ", tz, 1);
-	else
-		unsetenv("TZ");
-	tzset();
-
-	timestamp_microseconds=date_between_record_date_year2000+timeSinceEpoch*1000000;
+	timestamp=BtSnoopTimestamp::decode(data);
 }
 
 /**
  * @brief
  *      print info in debug mode
  */
-void BtSnoopPacket::printInfo(){
+void BtSnoopPacket::printInfo() const{
 
 	#ifdef __ANDROID__
 
 	__android_log_print(ANDROID_LOG_VERBOSE,"snoop packet","original length           : %d\n",original_length);
 	__android_log_print(ANDROID_LOG_VERBOSE,"snoop packet","included length           : %d\n",included_length);
 	__android_log_print(ANDROID_LOG_VERBOSE,"snoop packet","cumulative drops          : %d\n",cumulative_drops);
-	__android_log_print(ANDROID_LOG_VERBOSE,"snoop packet","packet_received           : %d\n",packet_received );
-	__android_log_print(ANDROID_LOG_VERBOSE,"snoop packet","packet_sent               : %d\n",packet_sent);
-	__android_log_print(ANDROID_LOG_VERBOSE,"snoop packet","packet_type_command_event : %d\n",packet_type_command_event );
-	__android_log_print(ANDROID_LOG_VERBOSE,"snoop packet","packet_type_data          : %d\n",packet_type_data);
+	__android_log_print(ANDROID_LOG_VERBOSE,"snoop packet","packet_received           : %d\n",is_packet_received() );
+	__android_log_print(ANDROID_LOG_VERBOSE,"snoop packet","packet_sent               : %d\n",is_packet_sent());
+	__android_log_print(ANDROID_LOG_VERBOSE,"snoop packet","packet_type_command_event : %d\n",is_command_event() );
+	__android_log_print(ANDROID_LOG_VERBOSE,"snoop packet","packet_type_data          : %d\n",is_data());
 	__android_log_print(ANDROID_LOG_VERBOSE,"snoop packet","--------------------------\n");
 
 	#else
@@ -152,11 +87,11 @@ void BtSnoopPacket::printInfo(){
 	cout << "original length           : " << original_length << endl;
 	cout << "included length           : " << included_length << endl;
 	cout << "cumulative drops          : " << cumulative_drops << endl;
-	cout << "packet_received           : " << packet_received << endl;
-	cout << "packet_sent               : " << packet_sent << endl;
-	cout << "packet_type_command_event : " << packet_type_command_event << endl;
-	cout << "packet_type_data          : " << packet_type_data << endl;
-	cout << "timestamp unix microsec   : " << timestamp_microseconds << endl;
+	cout << "packet_received           : " << is_packet_received() << endl;
+	cout << "packet_sent               : " << is_packet_sent() << endl;
+	cout << "packet_type_command_event : " << is_command_event() << endl;
+	cout << "packet_type_data          : " << is_data() << endl;
+	cout << "timestamp unix microsec   : " << getUnixTimestampMicroseconds() << endl;
 	cout << "data                      : ";
 
 	for (int i = 0; i  < included_length;i++){
@@ -173,18 +108,18 @@ void BtSnoopPacket::printInfo(){
  *      convert packet class to json
  * @param beautify beautify/uglify json
  */
-std::string BtSnoopPacket::toJson(bool beautify){
+std::string BtSnoopPacket::toJson(bool beautify) const{
 
 	Json::Value output;
 
 	output["original_length"] = original_length;
 	output["included_length"] = included_length;
 	output["cumulative_drops"] = cumulative_drops;
-	output["packet_received"] = packet_received;
-	output["packet_sent"] = packet_sent;
-	output["packet_type_command_event"] = packet_type_command_event;
-	output["packet_type_data"] = packet_type_data;
-	output["timestamp_microseconds"] = (double)timestamp_microseconds;
+	output["packet_received"] = is_packet_received();
+	output["packet_sent"] = is_packet_sent();
+	output["packet_type_command_event"] = is_command_event();
+	output["packet_type_data"] = is_data();
+	output["timestamp_microseconds"] = (double)getUnixTimestampMicroseconds();
 
 	Json::Value packet_data_vals(Json::arrayValue);
 	for (int i = 0; i  < included_length;i++){
@@ -210,11 +145,20 @@ BtSnoopPacket::~BtSnoopPacket(){
  *      decode packet data field
  * @param data
  */
-void BtSnoopPacket::decode_data(char * data){
+void BtSnoopPacket::decode_data(const char * data){
+	packet_data.assign(data, included_length > 0 ? included_length : 0);
+}
 
-	for (int i = 0; i  < included_length;i++){
-		packet_data.push_back(data[i]);
-	}
+/**
+ * @brief
+ *      decode packet data field into arena memory (packet data is valid until arena
+ *      is cleared, copies of this packet own their data)
+ * @param data
+ * @param arena
+ *      arena owning packet data
+ */
+void BtSnoopPacket::decode_data(const char * data,BtSnoopArena &arena){
+	packet_data.assign(data, included_length > 0 ? included_length : 0, arena);
 }
 
 /**
@@ -222,7 +166,7 @@ void BtSnoopPacket::decode_data(char * data){
  *      get length of original packet (could be more than this packet's length)
  * @return
  */
-int BtSnoopPacket::getOriginalLength(){
+int BtSnoopPacket::getOriginalLength() const{
 	return original_length;
 }
 
@@ -231,7 +175,7 @@ int BtSnoopPacket::getOriginalLength(){
  *      get packet data field length
  * @return
  */
-int BtSnoopPacket::getincludedLength(){
+int BtSnoopPacket::getincludedLength() const{
 	return included_length;
 }
 
@@ -240,7 +184,7 @@ int BtSnoopPacket::getincludedLength(){
  *      get number of packet lost between the first record and this record for this file
  * @return
  */
-int BtSnoopPacket::getCumulativeDrops(){
+int BtSnoopPacket::getCumulativeDrops() const{
 	return cumulative_drops;
 }
 
@@ -249,8 +193,17 @@ int BtSnoopPacket::getCumulativeDrops(){
  *       retrieve packet data
  * @return
  */
-std::vector<char> BtSnoopPacket::getPacketData(){
-	return packet_data;
+std::vector<char> BtSnoopPacket::getPacketData() const{
+	return std::vector<char>(packet_data.data(), packet_data.data() + packet_data.size());
+}
+
+/**
+ * @brief
+ *      get packet data field without copy (valid while this packet exists)
+ * @return
+ */
+BtSnoopDataSpan BtSnoopPacket::getPayload() const{
+	return packet_data.span();
 }
 
 /**
@@ -258,8 +211,27 @@ std::vector<char> BtSnoopPacket::getPacketData(){
  *      get unix timestamp for this packet record
  * @return
  */
-uint64_t BtSnoopPacket::getUnixTimestampMicroseconds(){
-	return timestamp_microseconds;
+uint64_t BtSnoopPacket::getUnixTimestampMicroseconds() const{
+	//epoch offset is a compile-time constant : no TZ / mktime call per packet
+	return BtSnoopTimestamp::toUnixMicroseconds(timestamp);
+}
+
+/**
+ * @brief
+ *      get unix timestamp in nanoseconds for this packet record
+ * @return
+ */
+uint64_t BtSnoopPacket::getUnixTimestampNanoseconds() const{
+	return BtSnoopTimestamp::toUnixNanoseconds(timestamp);
+}
+
+/**
+ * @brief
+ *      get btsnoop timestamp for this packet record (microseconds since 01/01/0 AD)
+ * @return
+ */
+uint64_t BtSnoopPacket::getTimestamp() const{
+	return timestamp;
 }
 
 /**
@@ -267,8 +239,8 @@ uint64_t BtSnoopPacket::getUnixTimestampMicroseconds(){
  *      define if packet record is sent
  * @return
  */
-bool BtSnoopPacket::is_packet_sent(){
-	return packet_sent;
+bool BtSnoopPacket::is_packet_sent() const{
+	return (flags & PACKET_FLAG_RECEIVED) == 0;
 }
 
 /**
@@ -276,8 +248,8 @@ bool BtSnoopPacket::is_packet_sent(){
  *      define if packet record is received
  * @return
  */
-bool BtSnoopPacket::is_packet_received(){
-	return packet_received;
+bool BtSnoopPacket::is_packet_received() const{
+	return (flags & PACKET_FLAG_RECEIVED) != 0;
 }
 
 /**
@@ -285,8 +257,8 @@ bool BtSnoopPacket::is_packet_received(){
  *      define if packet record is data record
  * @return
  */
-bool BtSnoopPacket::is_data(){
-	return packet_type_data;
+bool BtSnoopPacket::is_data() const{
+	return (flags & PACKET_FLAG_COMMAND_EVENT) == 0;
 }
 
 /**
@@ -294,6 +266,6 @@ bool BtSnoopPacket::is_data(){
  *      define if packet record is command or event
  * @return
  */
-bool BtSnoopPacket::is_command_event(){
-	return packet_type_command_event;
+bool BtSnoopPacket::is_command_event() const{
+	return (flags & PACKET_FLAG_COMMAND_EVENT) != 0;
 }
\ No newline at end of file
@@ -0,0 +1,407 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooppacketreader.cpp
+
+	Random access to packet records by packet number : record positions are
+	indexed once and pages of decoded packets are kept in a LRU cache
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnooppacketreader.h"
+#include "btsnoop/btsnoopheaderdecoder.h"
+#include "btsnoop/btsnoopdecompresssource.h"
+#include "btsnoop/btsnoopendian.h"
+#include "algorithm"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+BtSnoopPacketReader::BtSnoopPacketReader(){
+	fd = -1;
+	indexed_end = 0;
+	cache_size = READER_CACHE_PAGES;
+}
+
+BtSnoopPacketReader::~BtSnoopPacketReader(){
+	close();
+}
+
+/**
+ * @brief
+ *      open btsnoop file and index position of all packet records
+ * @param file_path
+ *      btsnoop file path (uncompressed)
+ * @param index_file
+ *      use persistent sidecar index (<file>.idx) instead of reading all records
+ * @return
+ *      success status
+ */
+bool BtSnoopPacketReader::open(std::string file_path,bool index_file){
+
+	close();
+
+	fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+
+	if (fd == -1){
+		return false;
+	}
+
+	char file_header[16];
+
+	//records are read at their position : compressed files are not supported
+	if (pread(fd, file_header, 16, 0) != 16 || BtSnoopDecompressSource::detect(file_header, 16) != COMPRESSION_NONE){
+		close();
+		return false;
+	}
+
+	fileInfo = BtSnoopFileInfo(file_header);
+	indexed_end = 16;
+
+	if (index_file){
+		index_path = file_path + INDEX_FILE_EXTENSION;
+		this->index_file.load(index_path, fd);
+	}
+
+	refresh();
+	return true;
+}
+
+/**
+ * @brief
+ *      close btsnoop file and release index / cache
+ */
+void BtSnoopPacketReader::close(){
+
+	if (fd != -1){
+		::close(fd);
+		fd = -1;
+	}
+	index_path.clear();
+	index_file.reset();
+	offsets.clear();
+	indexed_end = 0;
+	cache.clear();
+	cache_pages.clear();
+	std::vector<char>().swap(buffer);
+}
+
+/**
+ * @brief
+ *      index packet records appended to btsnoop file since last call (file being
+ *      written)
+ * @return
+ *      number of new packets
+ */
+size_t BtSnoopPacketReader::refresh(){
+
+	if (fd == -1){
+		return 0;
+	}
+
+	size_t count = getPacketCount();
+	size_t added = 0;
+
+	if (!index_path.empty()){
+		added = index_file.update(fd);
+		index_file.save();
+	}
+	else{
+		added = index_records();
+	}
+
+	//last page may have been decoded with less packets
+	if (added > 0 && count % READER_PAGE_SIZE != 0){
+
+		std::map<size_t, std::list<BtSnoopReaderPage>::iterator>::iterator cached = cache_pages.find(count / READER_PAGE_SIZE);
+
+		if (cached != cache_pages.end()){
+			cache.erase(cached->second);
+			cache_pages.erase(cached);
+		}
+	}
+	return added;
+}
+
+/**
+ * @brief
+ *      index position of packet records from end of indexed records
+ * @return
+ *      number of new packets
+ */
+size_t BtSnoopPacketReader::index_records(){
+
+	struct stat file_stat;
+
+	if (fstat(fd, &file_stat) == -1){
+		return 0;
+	}
+
+	std::vector<char> data(INDEX_READ_SIZE);
+
+	size_t max_count = INDEX_READ_SIZE / 24;
+
+	std::vector<size_t> record_offsets(max_count);
+
+	//only record positions are needed
+	BtSnoopHeaderColumns columns;
+	columns.offsets = &record_offsets[0];
+	columns.original_lengths = 0;
+	columns.included_lengths = 0;
+	columns.flags = 0;
+	columns.cumulative_drops = 0;
+	columns.timestamps = 0;
+
+	size_t first = offsets.size();
+
+	while (indexed_end < file_stat.st_size){
+
+		ssize_t length = pread(fd, &data[0], data.size(), indexed_end);
+
+		if (length <= 0){
+			break;
+		}
+
+		size_t consumed = 0;
+		size_t count = BtSnoopHeaderDecoder::decode(&data[0], length, max_count, columns, consumed);
+
+		for (size_t i = 0; i < count;i++){
+			offsets.push_back(indexed_end + record_offsets[i]);
+		}
+
+		if (count == 0){
+
+			//incomplete record at end of file
+			if ((size_t)length < data.size() || length < 24){
+				break;
+			}
+
+			int64_t record_size = 24 + (int64_t)btsnoop_read_be32(&data[4]);
+
+			if (record_size > file_stat.st_size - indexed_end){
+				break;
+			}
+			//record bigger than read buffer
+			data.resize(record_size);
+		}
+		indexed_end += consumed;
+	}
+	return offsets.size() - first;
+}
+
+/**
+ * @brief
+ *      set maximum number of cached pages (READER_PAGE_SIZE packets each)
+ * @param pages
+ *      number of pages (at least 1)
+ */
+void BtSnoopPacketReader::set_cache_size(size_t pages){
+
+	cache_size = pages > 0 ? pages : 1;
+
+	while (cache.size() > cache_size){
+		cache_pages.erase(cache.back().number);
+		cache.pop_back();
+	}
+}
+
+/**
+ * @brief
+ *      get file information header object
+ * @return
+ */
+BtSnoopFileInfo BtSnoopPacketReader::getFileInfo(){
+	return fileInfo;
+}
+
+/**
+ * @brief
+ *      get number of indexed packets
+ * @return
+ */
+size_t BtSnoopPacketReader::getPacketCount() const{
+	return index_path.empty() ? offsets.size() : index_file.size();
+}
+
+/**
+ * @brief
+ *      get position of a packet record (or of end of indexed records)
+ * @param number
+ *      packet number (<= getPacketCount())
+ * @return
+ */
+int64_t BtSnoopPacketReader::position(size_t number) const{
+
+	if (!index_path.empty()){
+		return number < index_file.size() ? index_file.getOffset(number) : index_file.getIndexedEnd();
+	}
+	return number < offsets.size() ? offsets[number] : indexed_end;
+}
+
+/**
+ * @brief
+ *      get a page from cache or decode it
+ * @param number
+ *      page number
+ * @return
+ *      page (0 if it cant be read)
+ */
+const BtSnoopReaderPage * BtSnoopPacketReader::page(size_t number){
+
+	std::map<size_t, std::list<BtSnoopReaderPage>::iterator>::iterator cached = cache_pages.find(number);
+
+	if (cached != cache_pages.end()){
+		//most recently used page is moved to front
+		cache.splice(cache.begin(), cache, cached->second);
+		return &cache.front();
+	}
+
+	size_t first = number * READER_PAGE_SIZE;
+	size_t last = std::min(first + READER_PAGE_SIZE, getPacketCount());
+
+	if (first >= last){
+		return 0;
+	}
+
+	int64_t start = position(first);
+	size_t size = position(last) - start;
+
+	//all records of the page are read at once
+	buffer.resize(size);
+
+	size_t done = 0;
+
+	while (done < size){
+
+		ssize_t length = pread(fd, &buffer[done], size - done, start + done);
+
+		if (length <= 0){
+			shrink_buffer();
+			return 0;
+		}
+		done += length;
+	}
+
+	//least recently used page is released
+	if (cache.size() >= cache_size){
+		cache_pages.erase(cache.back().number);
+		cache.pop_back();
+	}
+
+	cache.push_front(BtSnoopReaderPage());
+
+	BtSnoopReaderPage &loaded = cache.front();
+	loaded.number = number;
+	loaded.packets.reserve(last - first);
+
+	for (size_t i = first; i < last;i++){
+
+		const char * record = &buffer[position(i) - start];
+
+		//packet is built in place : payload is allocated once
+		loaded.packets.emplace_back(record);
+		loaded.packets.back().decode_data(record + 24);
+	}
+	cache_pages[number] = cache.begin();
+
+	shrink_buffer();
+
+	return &loaded;
+}
+
+/**
+ * @brief
+ *      release read buffer if a page with big records made it grow over
+ *      READER_BUFFER_SIZE
+ */
+void BtSnoopPacketReader::shrink_buffer(){
+
+	if (buffer.capacity() > READER_BUFFER_SIZE){
+		std::vector<char>().swap(buffer);
+	}
+}
+
+/**
+ * @brief
+ *      get a packet by number
+ * @param number
+ *      packet number (< getPacketCount())
+ * @param packet
+ *      decoded packet
+ * @return
+ *      success status
+ */
+bool BtSnoopPacketReader::getPacket(size_t number,BtSnoopPacket &packet){
+
+	if (number >= getPacketCount()){
+		return false;
+	}
+
+	const BtSnoopReaderPage * loaded = page(number / READER_PAGE_SIZE);
+
+	if (loaded == 0){
+		return false;
+	}
+	packet = loaded->packets[number % READER_PAGE_SIZE];
+	return true;
+}
+
+/**
+ * @brief
+ *      get consecutive packets
+ * @param first
+ *      first packet number
+ * @param count
+ *      number of packets (less packets are returned at end of file)
+ * @return
+ *      decoded packets
+ */
+std::vector<BtSnoopPacket> BtSnoopPacketReader::getPackets(size_t first,size_t count){
+
+	std::vector<BtSnoopPacket> packets;
+
+	size_t last = first + std::min(count, getPacketCount() > first ? getPacketCount() - first : 0);
+
+	packets.reserve(last - first);
+
+	size_t number = first;
+
+	while (number < last){
+
+		const BtSnoopReaderPage * loaded = page(number / READER_PAGE_SIZE);
+
+		if (loaded == 0){
+			break;
+		}
+
+		size_t page_first = (number / READER_PAGE_SIZE) * READER_PAGE_SIZE;
+		size_t page_last = std::min(page_first + loaded->packets.size(), last);
+
+		packets.insert(packets.end(), loaded->packets.begin() + (number - page_first), loaded->packets.begin() + (page_last - page_first));
+		number = page_last;
+	}
+	return packets;
+}
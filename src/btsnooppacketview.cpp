@@ -0,0 +1,194 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooppacketview.cpp
+
+	Non-owning view over a bt snoop packet record. Header fields are decoded
+	on demand from the raw 24 bytes header
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnooppacketview.h"
+#include "btsnoop/btsnooptimestamp.h"
+#include "btsnoop/btsnoopendian.h"
+
+/**
+ * @brief
+ *      build a view over a packet record
+ * @param header
+ *      record header of size 24 (4 + 4 + 4 + 4 + 8)
+ * @param data
+ *      packet data field (included length bytes)
+ */
+BtSnoopPacketView::BtSnoopPacketView(const char * header,const char * data){
+	this->header = header;
+	this->data = data;
+}
+
+/**
+ * @brief
+ *      decode big endian 32 bit header field
+ * @param offset
+ *      field offset in header
+ * @return
+ */
+uint32_t BtSnoopPacketView::field(int offset) const{
+	return btsnoop_read_be32(header + offset);
+}
+
+/**
+ * @brief
+ *      get length of original packet (could be more than this packet's length)
+ * @return
+ */
+int BtSnoopPacketView::getOriginalLength() const{
+	return field(0);
+}
+
+/**
+ * @brief
+ *      get packet data field length
+ * @return
+ */
+int BtSnoopPacketView::getincludedLength() const{
+	return field(4);
+}
+
+/**
+ * @brief
+ *      get number of packet lost between the first record and this record for this file
+ * @return
+ */
+int BtSnoopPacketView::getCumulativeDrops() const{
+	return field(12);
+}
+
+/**
+ * @brief
+ *      get btsnoop timestamp for this packet record (microseconds since 01/01/0 AD)
+ * @return
+ */
+uint64_t BtSnoopPacketView::getTimestamp() const{
+	return BtSnoopTimestamp::decode(header);
+}
+
+/**
+ * @brief
+ *      get unix timestamp for this packet record
+ * @return
+ */
+uint64_t BtSnoopPacketView::getUnixTimestampMicroseconds() const{
+	return BtSnoopTimestamp::toUnixMicroseconds(getTimestamp());
+}
+
+/**
+ * @brief
+ *      define if packet record is sent
+ * @return
+ */
+bool BtSnoopPacketView::is_packet_sent() const{
+	return (header[11] & 0x01) == 0;
+}
+
+/**
+ * @brief
+ *      define if packet record is received
+ * @return
+ */
+bool BtSnoopPacketView::is_packet_received() const{
+	return (header[11] & 0x01) != 0;
+}
+
+/**
+ * @brief
+ *      define if packet record is data record
+ * @return
+ */
+bool BtSnoopPacketView::is_data() const{
+	return (header[11] & 0x02) == 0;
+}
+
+/**
+ * @brief
+ *      define if packet record is command or event
+ * @return
+ */
+bool BtSnoopPacketView::is_command_event() const{
+	return (header[11] & 0x02) != 0;
+}
+
+/**
+ * @brief
+ *      get packet data field without copy
+ * @return
+ */
+BtSnoopDataSpan BtSnoopPacketView::getPayload() const{
+	return BtSnoopDataSpan(data, (unsigned int)getincludedLength());
+}
+
+/**
+ * @brief
+ *      get raw record header (24 bytes)
+ * @return
+ */
+const char * BtSnoopPacketView::getHeader() const{
+	return header;
+}
+
+/**
+ * @brief
+ *      get raw packet data field (included length bytes)
+ * @return
+ */
+const char * BtSnoopPacketView::getData() const{
+	return data;
+}
+
+/**
+ * @brief
+ *      build an owning packet from this view (header decoding + data copy)
+ * @return
+ */
+BtSnoopPacket BtSnoopPacketView::toPacket() const{
+
+	BtSnoopPacket packet(header);
+	packet.decode_data(data);
+	return packet;
+}
+
+/**
+ * @brief
+ *      build a packet from this view with packet data copied into arena memory
+ * @param arena
+ *      arena owning packet data
+ * @return
+ */
+BtSnoopPacket BtSnoopPacketView::toPacket(BtSnoopArena &arena) const{
+
+	BtSnoopPacket packet(header);
+	packet.decode_data(data, arena);
+	return packet;
+}
@@ -45,6 +45,10 @@ using namespace std;
 BtSnoopParser::BtSnoopParser() {
 
 	thread_started=false;
+	drain_rotated=true;
+	retention=RETENTION_ALL;
+	retention_limit=0;
+	index_file=false;
 
 }
 
@@ -71,12 +75,24 @@ void BtSnoopParser::addSnoopListener(IBtSnoopListener* listener){
 
 }
 
+/**
+ * @brief
+ *      add a record listener (views by const reference / batch delivery)
+ * @param listener
+ */
+void BtSnoopParser::addSnoopListener(IBtSnoopRecordListener* listener){
+
+	recordListenerList.push_back(listener);
+
+}
+
 /**
  * @brief
  *      remove all listeners in snoop listener list
  */
 void BtSnoopParser::clearListeners(){
 	snoopListenerList.clear();
+	recordListenerList.clear();
 }
 
 /**
@@ -85,8 +101,11 @@ void BtSnoopParser::clearListeners(){
  */
 void BtSnoopParser::join(){
 
-	if (thread_started)
+	//thread can only be joined once (destructor joins it too)
+	if (thread_started){
 		(void)pthread_join(decode_task,NULL);
+		thread_started=false;
+	}
 }
 
 /**
@@ -99,6 +118,42 @@ void BtSnoopParser::stop(){
 	join();
 }
 
+/**
+ * @brief
+ *      when streamed file is rotated (moved and recreated), decode packets remaining
+ *      in rotated file before resuming from the header of the new file
+ * @param drain_rotated
+ *      drain rotated file (default true)
+ */
+void BtSnoopParser::set_drain_rotated(bool drain_rotated){
+	this->drain_rotated = drain_rotated;
+}
+
+/**
+ * @brief
+ *      bound packets retained by decoding task (oldest packets are evicted)
+ * @param policy
+ *      RETENTION_ALL (default), RETENTION_NONE (listeners only),
+ *      RETENTION_LAST_PACKETS, RETENTION_LAST_SECONDS or RETENTION_BYTES
+ * @param limit
+ *      number of packets / seconds / bytes
+ */
+void BtSnoopParser::set_retention_policy(retention_policy policy,uint64_t limit){
+	retention = policy;
+	retention_limit = limit;
+}
+
+/**
+ * @brief
+ *      count packets of decode_streaming_file(file_path,packetNumber) with a
+ *      persistent sidecar index (<file>.idx) updated with appended packets only
+ * @param enabled
+ *      use sidecar index (default false)
+ */
+void BtSnoopParser::set_index_file(bool enabled){
+	index_file = enabled;
+}
+
 /**
  * @brief
  *      decode streaming file
@@ -115,18 +170,11 @@ bool BtSnoopParser::decode_streaming_file(std::string file_path){
 		(void)pthread_join(decode_task,NULL);
 
 	snoop_task= BtSnoopTask(file_path,&snoopListenerList);
+	snoop_task.set_record_listeners(&recordListenerList);
+	snoop_task.set_drain_rotated(drain_rotated);
+	snoop_task.set_retention_policy(retention, retention_limit);
 
-	int rc = pthread_create(&decode_task, NULL,&BtSnoopTask::decoding_helper,(void*)&snoop_task);
-
-	if (rc){
-		cerr << "Error:unable to create thread," << rc << endl;
-		return false;
-	}
-	else{
-		thread_started=true;
-	}
-
-	return true;
+	return start_decoding_task();
 }
 
 /**
@@ -147,6 +195,43 @@ bool BtSnoopParser::decode_streaming_file(std::string file_path, int packetNumbe
 		(void)pthread_join(decode_task,NULL);
 
 	snoop_task= BtSnoopTask(file_path,&snoopListenerList,packetNumber);
+	snoop_task.set_record_listeners(&recordListenerList);
+	snoop_task.set_drain_rotated(drain_rotated);
+	snoop_task.set_index_file(index_file);
+	snoop_task.set_retention_policy(retention, retention_limit);
+
+	return start_decoding_task();
+}
+
+/**
+ * @brief
+ *      decode btsnoop data from a non-seekable byte source (stdin, FIFO, unix socket, TCP)
+ * @param source
+ *      byte source (must remain valid until decoding is stopped)
+ * @return
+ *      success status
+ */
+bool BtSnoopParser::decode_streaming_source(IBtSnoopSource * source){
+
+	snoop_task.stop();
+
+	if (thread_started)
+		(void)pthread_join(decode_task,NULL);
+
+	snoop_task= BtSnoopTask(source,&snoopListenerList);
+	snoop_task.set_record_listeners(&recordListenerList);
+	snoop_task.set_retention_policy(retention, retention_limit);
+
+	return start_decoding_task();
+}
+
+/**
+ * @brief
+ *      start decoding thread for current snoop task
+ * @return
+ *      success status
+ */
+bool BtSnoopParser::start_decoding_task(){
 
 	int rc = pthread_create(&decode_task, NULL,&BtSnoopTask::decoding_helper,(void*)&snoop_task);
 
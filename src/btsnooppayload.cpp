@@ -0,0 +1,233 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooppayload.cpp
+
+	Packet data field stored inline (short payloads), in an owned heap buffer or
+	borrowed from a BtSnoopArena
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnooppayload.h"
+#include <string.h>
+
+BtSnoopPayload::BtSnoopPayload(){
+	length = 0;
+}
+
+/**
+ * @brief
+ *      copy of a payload is always owned : it remains valid when arena is released
+ */
+BtSnoopPayload::BtSnoopPayload(const BtSnoopPayload& payload){
+	length = 0;
+	assign(payload.data(), payload.size());
+}
+
+BtSnoopPayload& BtSnoopPayload::operator=(const BtSnoopPayload& payload){
+	if (this != &payload){
+		assign(payload.data(), payload.size());
+	}
+	return *this;
+}
+
+/**
+ * @brief
+ *      moved payload keeps pointing to the same memory (borrowed payload stays in arena)
+ */
+BtSnoopPayload::BtSnoopPayload(BtSnoopPayload&& payload) noexcept{
+	length = 0;
+	*this = static_cast<BtSnoopPayload&&>(payload);
+}
+
+BtSnoopPayload& BtSnoopPayload::operator=(BtSnoopPayload&& payload) noexcept{
+
+	if (this != &payload){
+
+		release();
+
+		//inline bytes or pointer (heap buffer is taken over, arena memory is still borrowed)
+		memcpy(inline_data, payload.inline_data, PAYLOAD_INLINE_SIZE);
+		length = payload.length;
+
+		payload.length = 0;
+	}
+	return *this;
+}
+
+BtSnoopPayload::~BtSnoopPayload(){
+	release();
+}
+
+/**
+ * @brief
+ *      release heap buffer and set payload empty
+ */
+void BtSnoopPayload::release(){
+	if (getStorage() == PAYLOAD_HEAP){
+		delete[] getExternal();
+	}
+	length = 0;
+}
+
+/**
+ * @brief
+ *      set payload to external memory
+ * @param storage
+ *      heap (owned) or arena memory
+ * @param ptr
+ *      first byte
+ * @param size
+ *      number of bytes
+ */
+void BtSnoopPayload::set_external(payload_storage storage,const char * ptr,size_t size){
+	memcpy(inline_data, &ptr, sizeof(ptr));
+	length = (uint32_t)size | ((uint32_t)storage << PAYLOAD_STORAGE_SHIFT);
+}
+
+/**
+ * @brief
+ *      get where payload is stored
+ * @return
+ */
+payload_storage BtSnoopPayload::getStorage() const{
+	return (payload_storage)(length >> PAYLOAD_STORAGE_SHIFT);
+}
+
+/**
+ * @brief
+ *      get first byte of heap buffer or arena memory
+ * @return
+ */
+const char * BtSnoopPayload::getExternal() const{
+	const char * ptr;
+	memcpy(&ptr, inline_data, sizeof(ptr));
+	return ptr;
+}
+
+/**
+ * @brief
+ *      set payload to an owned copy of data (inline if short enough)
+ * @param data
+ *      data to copy
+ * @param size
+ *      number of bytes
+ */
+void BtSnoopPayload::assign(const char * data,size_t size){
+
+	if (size <= PAYLOAD_INLINE_SIZE){
+		//data may be in current heap buffer or inline buffer : copy before release
+		char buffer[PAYLOAD_INLINE_SIZE];
+
+		if (size > 0){
+			memcpy(buffer, data, size);
+		}
+		release();
+		memcpy(inline_data, buffer, size);
+		length = (uint32_t)size;
+	}
+	else{
+		char * buffer = new char[size];
+		memcpy(buffer, data, size);
+		release();
+		set_external(PAYLOAD_HEAP, buffer, size);
+	}
+}
+
+/**
+ * @brief
+ *      set payload to a copy of data : short payloads are stored inline, others
+ *      are allocated in arena (valid until arena is cleared)
+ * @param data
+ *      data to copy
+ * @param size
+ *      number of bytes
+ * @param arena
+ *      arena owning the copy
+ */
+void BtSnoopPayload::assign(const char * data,size_t size,BtSnoopArena &arena){
+
+	if (size <= PAYLOAD_INLINE_SIZE){
+		assign(data, size);
+		return;
+	}
+	const char * copy = arena.copy(data, size);
+
+	release();
+	set_external(PAYLOAD_ARENA, copy, size);
+}
+
+/**
+ * @brief
+ *      get first byte
+ * @return
+ */
+const char * BtSnoopPayload::data() const{
+	if (getStorage() == PAYLOAD_INLINE){
+		return length > 0 ? inline_data : 0;
+	}
+	return getExternal();
+}
+
+/**
+ * @brief
+ *      get number of bytes
+ * @return
+ */
+size_t BtSnoopPayload::size() const{
+	return length & PAYLOAD_LENGTH_MASK;
+}
+
+/**
+ * @brief
+ *      get payload as a non-owning span
+ * @return
+ */
+BtSnoopDataSpan BtSnoopPayload::span() const{
+	return BtSnoopDataSpan(data(), size());
+}
+
+/**
+ * @brief
+ *      define if payload memory belongs to an arena
+ * @return
+ */
+bool BtSnoopPayload::is_borrowed() const{
+	return getStorage() == PAYLOAD_ARENA;
+}
+
+/**
+ * @brief
+ *      define if payload is stored in this object
+ * @return
+ */
+bool BtSnoopPayload::is_inline() const{
+	return getStorage() == PAYLOAD_INLINE && length > 0;
+}
+
+char BtSnoopPayload::operator[](size_t index) const{
+	return data()[index];
+}
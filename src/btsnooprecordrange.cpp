@@ -0,0 +1,97 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooprecordrange.cpp
+
+	Non-copying range over packet records retained by a decoding task. Iterators
+	are index based : they remain valid while new records are appended
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnooprecordrange.h"
+
+/**
+ * @brief
+ *      build a range over records [begin, end[
+ * @param records
+ *      retained records
+ * @param begin
+ *      index of first record
+ * @param end
+ *      index after last record
+ */
+BtSnoopRecordRange::BtSnoopRecordRange(const std::deque<BtSnoopPacket> * records,size_t begin,size_t end){
+	this->records = records;
+	first = begin;
+	last = end;
+}
+
+/**
+ * @brief
+ *      get iterator on first record
+ * @return
+ */
+BtSnoopRecordRange::const_iterator BtSnoopRecordRange::begin() const{
+	return const_iterator(records, first);
+}
+
+/**
+ * @brief
+ *      get iterator after last record
+ * @return
+ */
+BtSnoopRecordRange::const_iterator BtSnoopRecordRange::end() const{
+	return const_iterator(records, last);
+}
+
+/**
+ * @brief
+ *      get number of records in range
+ * @return
+ */
+size_t BtSnoopRecordRange::size() const{
+	return last - first;
+}
+
+/**
+ * @brief
+ *      define if range is empty
+ * @return
+ */
+bool BtSnoopRecordRange::empty() const{
+	return last == first;
+}
+
+/**
+ * @brief
+ *      get record by position in range
+ * @param index
+ *      position in range
+ * @return
+ */
+const BtSnoopPacket & BtSnoopRecordRange::operator[](size_t index) const{
+	return (*records)[first + index];
+}
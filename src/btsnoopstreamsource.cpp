@@ -0,0 +1,296 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopstreamsource.cpp
+
+	Non-seekable btsnoop byte source : stdin, FIFO, unix domain socket or TCP connection
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnoopstreamsource.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+
+BtSnoopStreamSource::BtSnoopStreamSource(){
+	fd = -1;
+	owned = false;
+	interrupt_pipe[0] = -1;
+	interrupt_pipe[1] = -1;
+	pthread_mutex_init(&lock, NULL);
+}
+
+/**
+ * @brief
+ *      close stream
+ */
+BtSnoopStreamSource::~BtSnoopStreamSource(){
+	close();
+	pthread_mutex_destroy(&lock);
+}
+
+/**
+ * @brief
+ *      use file descriptor as stream
+ * @param fd
+ *      opened file descriptor
+ * @param owned
+ *      close file descriptor when closing stream
+ * @return
+ *      success status
+ */
+bool BtSnoopStreamSource::attach(int fd,bool owned){
+
+	pthread_mutex_lock(&lock);
+	int rc = pipe2(interrupt_pipe, O_NONBLOCK | O_CLOEXEC);
+	pthread_mutex_unlock(&lock);
+
+	if (rc == -1){
+		interrupt_pipe[0] = -1;
+		interrupt_pipe[1] = -1;
+		if (owned){
+			::close(fd);
+		}
+		return false;
+	}
+
+	this->fd = fd;
+	this->owned = owned;
+
+	return true;
+}
+
+/**
+ * @brief
+ *      read from standard input
+ * @return
+ *      success status
+ */
+bool BtSnoopStreamSource::open_stdin(){
+
+	close();
+
+	return attach(STDIN_FILENO, false);
+}
+
+/**
+ * @brief
+ *      read from a FIFO or character device (blocks until a FIFO writer is connected)
+ * @param path
+ *      FIFO path
+ * @return
+ *      success status
+ */
+bool BtSnoopStreamSource::open_path(std::string path){
+
+	close();
+
+	int path_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+	if (path_fd == -1){
+		return false;
+	}
+	return attach(path_fd, true);
+}
+
+/**
+ * @brief
+ *      connect to a unix domain stream socket
+ * @param socket_path
+ *      socket path
+ * @return
+ *      success status
+ */
+bool BtSnoopStreamSource::connect_unix(std::string socket_path){
+
+	close();
+
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	if (socket_path.size() >= sizeof(address.sun_path)){
+		return false;
+	}
+	strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+	int socket_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+	if (socket_fd == -1){
+		return false;
+	}
+
+	if (connect(socket_fd, (struct sockaddr *)&address, sizeof(address)) == -1){
+		::close(socket_fd);
+		return false;
+	}
+	return attach(socket_fd, true);
+}
+
+/**
+ * @brief
+ *      connect to a TCP server (for instance btsnoop socket port forwarded from an Android device)
+ * @param host
+ *      host name or address
+ * @param port
+ *      TCP port
+ * @return
+ *      success status
+ */
+bool BtSnoopStreamSource::connect_tcp(std::string host,int port){
+
+	close();
+
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	char port_str[16];
+	snprintf(port_str, sizeof(port_str), "%d", port);
+
+	struct addrinfo * addresses = 0;
+
+	if (getaddrinfo(host.c_str(), port_str, &hints, &addresses) != 0){
+		return false;
+	}
+
+	int socket_fd = -1;
+
+	for (struct addrinfo * address = addresses; address != 0; address = address->ai_next){
+
+		socket_fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+
+		if (socket_fd == -1){
+			continue;
+		}
+		if (connect(socket_fd, address->ai_addr, address->ai_addrlen) == 0){
+			break;
+		}
+		::close(socket_fd);
+		socket_fd = -1;
+	}
+
+	freeaddrinfo(addresses);
+
+	if (socket_fd == -1){
+		return false;
+	}
+	return attach(socket_fd, true);
+}
+
+/**
+ * @brief
+ *      close stream (stdin is left open)
+ */
+void BtSnoopStreamSource::close(){
+
+	pthread_mutex_lock(&lock);
+
+	if (fd != -1 && owned){
+		::close(fd);
+	}
+	fd = -1;
+	owned = false;
+
+	for (int i = 0; i < 2;i++){
+		if (interrupt_pipe[i] != -1){
+			::close(interrupt_pipe[i]);
+			interrupt_pipe[i] = -1;
+		}
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+/**
+ * @brief
+ *      make pending and next read() return end of stream (may be called from any thread)
+ */
+void BtSnoopStreamSource::interrupt(){
+
+	pthread_mutex_lock(&lock);
+
+	if (interrupt_pipe[1] != -1){
+		char value = 1;
+		ssize_t rc = write(interrupt_pipe[1], &value, 1);
+		(void)rc;
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+/**
+ * @brief
+ *      read next bytes (blocking until at least one byte is available)
+ * @param data
+ *      destination buffer
+ * @param size
+ *      maximum number of bytes to read
+ * @return
+ *      number of bytes read, 0 on end of stream / interrupted, -1 on error
+ */
+ssize_t BtSnoopStreamSource::read(char * data,size_t size){
+
+	if (fd == -1){
+		return -1;
+	}
+
+	struct pollfd fds[2];
+	fds[0].fd = fd;
+	fds[0].events = POLLIN;
+	fds[1].fd = interrupt_pipe[0];
+	fds[1].events = POLLIN;
+
+	while (true){
+
+		int rc = poll(fds, 2, -1);
+
+		if (rc == -1){
+			if (errno == EINTR){
+				continue;
+			}
+			return -1;
+		}
+
+		if (fds[1].revents & POLLIN){
+			return 0;
+		}
+
+		ssize_t count = ::read(fd, data, size);
+
+		if (count == -1 && (errno == EINTR || errno == EAGAIN)){
+			continue;
+		}
+		return count;
+	}
+}
@@ -31,12 +31,22 @@
 */
 
 #include "btsnoop/btsnooptask.h"
-#include <fstream>
 #include "btsnoop/btsnoopfileinfo.h"
 #include "btsnoop/btsnooppacket.h"
 #include "iostream"
+#include "algorithm"
+#include <limits.h>
 #include <stdexcept>
 #include "btsnoop/btsnooperror.h"
+#include "btsnoop/btsnoopmappedfile.h"
+#include "btsnoop/btsnooppacketview.h"
+#include "btsnoop/btsnoopdecompresssource.h"
+#include "btsnoop/btsnoopheaderdecoder.h"
+#include "btsnoop/btsnooptimestamp.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
 
 #ifdef __ANDROID__
 
@@ -54,6 +64,22 @@ using namespace std;
  *
  */
 BtSnoopTask::BtSnoopTask(){
+	snoopListenerList = 0;
+	stream_fd = -1;
+	async_read = false;
+	drain_rotated = true;
+	recordListenerList = 0;
+	column_store_enabled = false;
+	packed_records_enabled = false;
+	retention = RETENTION_ALL;
+	retention_limit = 0;
+	evicted_count = 0;
+	retained_bytes = 0;
+	column_evicted = 0;
+	index_file_enabled = false;
+	packet_total = 0;
+	tail_count = 0;
+	source = 0;
 	#ifdef __ANDROID__
 	jni_env=0;
 	#endif //__ANDROID__
@@ -69,6 +95,21 @@ BtSnoopTask::BtSnoopTask(std::string file_path){
 	task_control=false;
 	state = FILE_HEADER;
 	this->packet_number = -1;
+	stream_fd = -1;
+	async_read = false;
+	drain_rotated = true;
+	recordListenerList = 0;
+	column_store_enabled = false;
+	packed_records_enabled = false;
+	retention = RETENTION_ALL;
+	retention_limit = 0;
+	evicted_count = 0;
+	retained_bytes = 0;
+	column_evicted = 0;
+	index_file_enabled = false;
+	packet_total = 0;
+	tail_count = 0;
+	source = 0;
 }
 
 /**
@@ -86,6 +127,51 @@ BtSnoopTask::BtSnoopTask(std::string file_path,std::vector<IBtSnoopListener*> *s
 	task_control=false;
 	state = FILE_HEADER;
 	this->packet_number = -1;
+	stream_fd = -1;
+	async_read = false;
+	drain_rotated = true;
+	recordListenerList = 0;
+	column_store_enabled = false;
+	packed_records_enabled = false;
+	retention = RETENTION_ALL;
+	retention_limit = 0;
+	evicted_count = 0;
+	retained_bytes = 0;
+	column_evicted = 0;
+	index_file_enabled = false;
+	packet_total = 0;
+	tail_count = 0;
+	source = 0;
+}
+
+/**
+ * @brief
+ *      build decoding task reading a non-seekable byte source (stdin, FIFO, socket)
+ * @param source
+ *      byte source (must remain valid until decoding is stopped)
+ * @param snoopListenerList
+ *      list of listeners to be notified when a packet is decoded
+ */
+BtSnoopTask::BtSnoopTask(IBtSnoopSource * source,std::vector<IBtSnoopListener*> *snoopListenerList){
+	this->snoopListenerList = snoopListenerList;
+	this->source = source;
+	task_control = false;
+	state = FILE_HEADER;
+	this->packet_number = -1;
+	stream_fd = -1;
+	async_read = false;
+	drain_rotated = true;
+	recordListenerList = 0;
+	column_store_enabled = false;
+	packed_records_enabled = false;
+	retention = RETENTION_ALL;
+	retention_limit = 0;
+	evicted_count = 0;
+	retained_bytes = 0;
+	column_evicted = 0;
+	index_file_enabled = false;
+	packet_total = 0;
+	tail_count = 0;
 }
 
 /**
@@ -104,6 +190,21 @@ BtSnoopTask::BtSnoopTask(std::string file_path,std::vector<IBtSnoopListener*> *s
 	task_control = false;
 	state = FILE_HEADER;
 	this->packet_number = packet_number;
+	stream_fd = -1;
+	async_read = false;
+	drain_rotated = true;
+	recordListenerList = 0;
+	column_store_enabled = false;
+	packed_records_enabled = false;
+	retention = RETENTION_ALL;
+	retention_limit = 0;
+	evicted_count = 0;
+	retained_bytes = 0;
+	column_evicted = 0;
+	index_file_enabled = false;
+	packet_total = 0;
+	tail_count = 0;
+	source = 0;
 }
 
 /**
@@ -112,6 +213,7 @@ BtSnoopTask::BtSnoopTask(std::string file_path,std::vector<IBtSnoopListener*> *s
  */
 BtSnoopTask::~BtSnoopTask(){
 	task_control=false;
+	file_watcher.wakeup();
 }
 
 /**
@@ -120,6 +222,293 @@ BtSnoopTask::~BtSnoopTask(){
  */
 void BtSnoopTask::stop(){
 	task_control=false;
+	file_watcher.wakeup();
+	if (source != 0){
+		source->interrupt();
+	}
+}
+
+/**
+ * @brief
+ *      read whole file passes (decode_file / packet counting) with several
+ *      io_uring reads in flight. Plain reads are used if io_uring is not available
+ * @param async_read
+ *      enable asynchronous reads
+ */
+void BtSnoopTask::set_async_read(bool async_read){
+	this->async_read = async_read;
+}
+
+/**
+ * @brief
+ *      when streamed file is rotated (moved and recreated), decode packets remaining
+ *      in rotated file before resuming from the header of the new file
+ * @param drain_rotated
+ *      drain rotated file (default true)
+ */
+void BtSnoopTask::set_drain_rotated(bool drain_rotated){
+	this->drain_rotated = drain_rotated;
+}
+
+/**
+ * @brief
+ *      count packets with a persistent sidecar index (<file>.idx) : only packet
+ *      records appended since index was saved are read
+ * @param enabled
+ *      use sidecar index (default false)
+ */
+void BtSnoopTask::set_index_file(bool enabled){
+	index_file_enabled = enabled;
+}
+
+/**
+ * @brief
+ *      fill columnar store with decoded packets (in addition to packet data records).
+ *      Packets evicted by retention policy are removed from column store by batch of
+ *      COLUMN_BATCH_SIZE packets (decode_file_mapped keeps all packets of the file)
+ * @param enabled
+ *      enable columnar store (default false)
+ */
+void BtSnoopTask::set_column_store(bool enabled){
+	column_store_enabled = enabled;
+}
+
+/**
+ * @brief
+ *      get columnar store of decoded packets (empty if not enabled)
+ * @return
+ */
+const BtSnoopColumnStore & BtSnoopTask::getColumnStore() const{
+	return column_store;
+}
+
+/**
+ * @brief
+ *      retain decoded packets as packed records instead of packet objects (for long
+ *      streaming sessions). getRecords() / getRecord() are then empty and
+ *      getPacketDataRecords() builds packets from packed records
+ * @param enabled
+ *      enable packed records (default false)
+ */
+void BtSnoopTask::set_packed_records(bool enabled){
+	packed_records_enabled = enabled;
+}
+
+/**
+ * @brief
+ *      get packed records store of decoded packets (empty if not enabled)
+ * @return
+ */
+const BtSnoopPackedStore & BtSnoopTask::getPackedStore() const{
+	return packed_store;
+}
+
+/**
+ * @brief
+ *      bound retained packets (packet data records or packed store). Oldest packets
+ *      are evicted in constant time once limit is exceeded. Eviction shifts record
+ *      indexes : ranges from getRecords() must not be kept across decoding. Bounded
+ *      packet data records are not arena backed : payloads bigger than
+ *      PAYLOAD_INLINE_SIZE are heap allocated (use packed records to avoid it).
+ *      Column store follows the same policy by batch of COLUMN_BATCH_SIZE packets
+ * @param policy
+ *      RETENTION_ALL (default), RETENTION_NONE (listeners only),
+ *      RETENTION_LAST_PACKETS, RETENTION_LAST_SECONDS or RETENTION_BYTES
+ * @param limit
+ *      number of packets / seconds before last packet timestamp / bytes (24 byte
+ *      record header + packet data per packet)
+ */
+void BtSnoopTask::set_retention_policy(retention_policy policy,uint64_t limit){
+	retention = policy;
+	retention_limit = limit;
+}
+
+/**
+ * @brief
+ *      get number of packets evicted (or not retained) because of retention policy
+ * @return
+ */
+uint64_t BtSnoopTask::getEvictedCount() const{
+	return evicted_count;
+}
+
+/**
+ * @brief
+ *      get size of retained packets (24 byte record header + packet data per packet)
+ * @return
+ *      number of bytes
+ */
+uint64_t BtSnoopTask::getRetainedBytes() const{
+	return retained_bytes;
+}
+
+/**
+ * @brief
+ *      retain a decoded packet according to retention policy
+ * @param view
+ *      packet record view
+ */
+void BtSnoopTask::retain(const BtSnoopPacketView &view){
+
+	if (retention == RETENTION_NONE){
+		evicted_count++;
+		evict_columns(1);
+		return;
+	}
+
+	if (packed_records_enabled){
+		packed_store.append(view);
+	}
+	else if (retention == RETENTION_ALL){
+		//packet data of retained packets is bump allocated in task arena
+		packetDataRecords.push_back(view.toPacket(payload_arena));
+	}
+	else{
+		//evicted packets must release their packet data : no arena
+		packetDataRecords.push_back(view.toPacket());
+	}
+
+	retained_bytes += 24 + (unsigned int)view.getincludedLength();
+
+	if (retention != RETENTION_ALL){
+		evict(view.getTimestamp());
+	}
+}
+
+/**
+ * @brief
+ *      evict packets from column store by batch of COLUMN_BATCH_SIZE packets (column
+ *      store keeps at most COLUMN_BATCH_SIZE packets more than retained packets)
+ * @param count
+ *      number of packets evicted by retention policy
+ */
+void BtSnoopTask::evict_columns(size_t count){
+
+	if (!column_store_enabled){
+		return;
+	}
+
+	column_evicted += count;
+
+	if (column_evicted >= COLUMN_BATCH_SIZE){
+		column_store.pop_front(std::min(column_evicted, column_store.size()));
+		column_evicted = 0;
+	}
+}
+
+/**
+ * @brief
+ *      evict oldest retained packets while retention limit is exceeded
+ * @param timestamp
+ *      timestamp of last retained packet
+ */
+void BtSnoopTask::evict(uint64_t timestamp){
+
+	//btsnoop timestamps are in microseconds
+	uint64_t oldest = 0;
+
+	if (retention == RETENTION_LAST_SECONDS && timestamp > retention_limit * 1000000){
+		oldest = timestamp - retention_limit * 1000000;
+	}
+
+	while (true){
+
+		size_t count = packed_records_enabled ? packed_store.size() : packetDataRecords.size();
+
+		if (count == 0){
+			return;
+		}
+
+		uint64_t front_timestamp = packed_records_enabled ? packed_store.getTimestamp(0) : packetDataRecords.front().getTimestamp();
+
+		bool exceeded = (retention == RETENTION_LAST_PACKETS && count > retention_limit) ||
+						(retention == RETENTION_LAST_SECONDS && front_timestamp < oldest) ||
+						(retention == RETENTION_BYTES && retained_bytes > retention_limit);
+
+		if (!exceeded){
+			return;
+		}
+
+		if (packed_records_enabled){
+			retained_bytes -= 24 + packed_store.getIncludedLength(0);
+			packed_store.pop_front();
+		}
+		else{
+			retained_bytes -= 24 + (unsigned int)packetDataRecords.front().getincludedLength();
+			packetDataRecords.pop_front();
+		}
+		evicted_count++;
+		evict_columns(1);
+	}
+}
+
+/**
+ * @brief
+ *      remove all retained packets and reset retention counters
+ */
+void BtSnoopTask::clear_records(){
+	packetDataRecords.clear();
+	payload_arena.clear();
+	column_store.clear();
+	packed_store.clear();
+	evicted_count = 0;
+	retained_bytes = 0;
+	column_evicted = 0;
+}
+
+/**
+ * @brief
+ *      set list of record listeners notified in addition to packet listeners
+ * @param recordListenerList
+ *      list of record listeners (must remain valid while decoding)
+ */
+void BtSnoopTask::set_record_listeners(std::vector<IBtSnoopRecordListener*> *recordListenerList){
+	this->recordListenerList = recordListenerList;
+}
+
+/**
+ * @brief
+ *      build list of notified listeners : legacy listeners are wrapped in adapters
+ */
+void BtSnoopTask::init_listeners(){
+
+	listeners.clear();
+	listener_adapters.clear();
+	batch.clear();
+
+	if (snoopListenerList!=0){
+
+		//adapters are all created before taking their address
+		for (unsigned int i = 0; i  < snoopListenerList->size();i++){
+			listener_adapters.push_back(BtSnoopListenerAdapter(snoopListenerList->at(i)));
+		}
+		for (unsigned int i = 0; i  < listener_adapters.size();i++){
+			listeners.push_back(&listener_adapters[i]);
+		}
+	}
+	if (recordListenerList!=0){
+		listeners.insert(listeners.end(), recordListenerList->begin(), recordListenerList->end());
+	}
+}
+
+/**
+ * @brief
+ *      deliver pending packet record views to all listeners
+ */
+void BtSnoopTask::notify_batch(){
+
+	if (batch.empty()){
+		return;
+	}
+
+	for (unsigned int i = 0; i  < listeners.size();i++){
+		#ifdef __ANDROID__
+		listeners[i]->onSnoopPacketBatch(fileInfo,&batch[0],batch.size(),jni_env);
+		#else
+		listeners[i]->onSnoopPacketBatch(fileInfo,&batch[0],batch.size());
+		#endif //__ANDROID__
+	}
+	batch.clear();
 }
 
 /**
@@ -155,16 +544,65 @@ void * BtSnoopTask::decoding_task(void) {
 
 	#endif // __ANDROID__
 
-	packetDataRecords.clear();
+	clear_records();
+	init_listeners();
 	task_control=true;
 	state = FILE_HEADER;
-	struct timespec tim, tim2;
-	tim.tv_sec = 0;
-	tim.tv_nsec = 1000000L * 200;
 
-	int index = 0;
+	if (source != 0){
+		stream_source();
+	}
+	else{
+		stream_file();
+	}
+	file_watcher.close();
+
+	#ifdef __ANDROID__
+
+
+	if (BtSnoopTask::jvm!=0){
+		BtSnoopTask::jvm->DetachCurrentThread();
+	}
+	else{
+		__android_log_print(ANDROID_LOG_ERROR,"snoop decoder","jvm not defined\n");
+	}
+    
+    #endif // __ANDROID__
+
+	return 0;
+}
+
+/**
+ * @brief
+ *      monitor snoop file for changes and decode appended packet records
+ */
+void BtSnoopTask::stream_file() {
+
+	//wake up only when file is modified (inotify) instead of periodic polling
+	file_watcher.open(file_path);
 
-	if (this->packet_number != -1){
+	//same descriptor is used for the whole streaming session
+	stream_fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+
+	int64_t index = 0;
+
+	if (stream_fd == -1){
+
+		#ifdef __ANDROID__
+		__android_log_print(ANDROID_LOG_ERROR,"snoop decoder","file could not be opened");
+		#else
+		cerr << "file could not be opened" << endl;
+		#endif // __ANDROID__
+		for (unsigned int i = 0; i  < listeners.size();i++){
+			#ifdef __ANDROID__
+			listeners[i]->onError(ERROR_OPENING,"file could not be opened",jni_env);
+			#else
+			listeners[i]->onError(ERROR_OPENING,"file could not be opened");
+			#endif //__ANDROID__
+		}
+		task_control=false;
+	}
+	else if (this->packet_number != -1){
 
 		//set index to the index of the begninning of the last this->packet_number packet
 		index = get_last_n_packet_index(this->packet_number);
@@ -172,52 +610,31 @@ void * BtSnoopTask::decoding_task(void) {
 		if (index == 0){
 			state = FILE_HEADER;
 		}
-		if (snoopListenerList!=0){
+		//listener count is an int : clamped for huge captures
+		int packet_count = (int)std::min(packet_total, (int64_t)INT_MAX);
 
-			for (unsigned int i = 0; i  < snoopListenerList->size();i++){
-				#ifdef __ANDROID__
-				snoopListenerList->at(i)->onFinishedCountingPackets(index_table.size(),jni_env);
-				#else
-				snoopListenerList->at(i)->onFinishedCountingPackets(index_table.size());
-				#endif //__ANDROID__
-			}
+		for (unsigned int i = 0; i  < listeners.size();i++){
+			#ifdef __ANDROID__
+			listeners[i]->onFinishedCountingPackets(packet_count,jni_env);
+			#else
+			listeners[i]->onFinishedCountingPackets(packet_count);
+			#endif //__ANDROID__
 		}
 	}
 
 	while (task_control) {
 		
 		try{
-			
-			ifstream fileStream(file_path.c_str());
-
-			if (fileStream.is_open()) {
-
-				fileStream.seekg (0, fileStream.end);
-				int length = fileStream.tellg();
-				fileStream.seekg(index,ios::beg);
-
-				if (!fileStream.eof() && fileStream.tellg()!=-1 && length!=index){
-					index = decode_streaming_file(&fileStream,index,false);
-				}
+			//resume from the header of the new file if snoop file has been rotated / truncated
+			if (stream_fd != -1){
+				check_rotation(index);
 			}
-			else{
-
-				#ifdef __ANDROID__
-				__android_log_print(ANDROID_LOG_ERROR,"snoop decoder","file could not be opened");
-				#else
-				cerr << "file could not be opened" << endl;
-				#endif // __ANDROID__
-				if (snoopListenerList!=0){
-
-					for (unsigned int i = 0; i  < snoopListenerList->size();i++){
-						#ifdef __ANDROID__
-						snoopListenerList->at(i)->onError(ERROR_OPENING,"file could not be opened",jni_env);
-						#else
-						snoopListenerList->at(i)->onError(ERROR_OPENING,"file could not be opened");
-						#endif //__ANDROID__
-					}
-				}
-				task_control=false;
+			if (stream_fd == -1){
+				stream_fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+			}
+			if (stream_fd != -1){
+				//only bytes appended since last iteration are read
+				index = decode_streaming_file(stream_fd,index,false);
 			}
 		}
 		catch(std::exception const& e) {
@@ -226,158 +643,445 @@ void * BtSnoopTask::decoding_task(void) {
 			#else
 			cerr << "Exception opening/reading file : " << e.what() << endl;
 			#endif // __ANDROID__
-			if (snoopListenerList!=0){
-
-				for (unsigned int i = 0; i  < snoopListenerList->size();i++){
-					#ifdef __ANDROID__
-					snoopListenerList->at(i)->onError(ERROR_UNKNOWN,e.what(),jni_env);
-					#else
-					snoopListenerList->at(i)->onError(ERROR_UNKNOWN,e.what());
-					#endif //__ANDROID__
-				}
+			for (unsigned int i = 0; i  < listeners.size();i++){
+				#ifdef __ANDROID__
+				listeners[i]->onError(ERROR_UNKNOWN,e.what(),jni_env);
+				#else
+				listeners[i]->onError(ERROR_UNKNOWN,e.what());
+				#endif //__ANDROID__
 			}
 			task_control=false;
 		}
-		nanosleep(&tim, &tim2);
+
+		if (task_control){
+			file_watcher.wait();
+		}
 	}
 
-	#ifdef __ANDROID__
+	if (stream_fd != -1){
+		close(stream_fd);
+		stream_fd = -1;
+	}
+}
 
+/**
+ * @brief
+ *      detect snoop file rotation (new inode at file path), truncation (file smaller
+ *      than current position) or rewrite (file header changed). Streaming restarts
+ *      from the header of the current file without reading previous packets again
+ * @param index
+ *      current position in streamed file (reset to 0 if file has changed)
+ * @return
+ *      true if file has changed (stream_fd is -1 if new file does not exist yet)
+ */
+bool BtSnoopTask::check_rotation(int64_t &index) {
 
-	if (BtSnoopTask::jvm!=0){
-		BtSnoopTask::jvm->DetachCurrentThread();
+	struct stat fd_stat;
+	struct stat path_stat;
+
+	if (fstat(stream_fd, &fd_stat) == -1){
+		return false;
+	}
+
+	bool replaced = false;
+
+	if (stat(file_path.c_str(), &path_stat) == -1){
+		//file moved or deleted, new file not created yet : rotated file is still decoded if drained
+		replaced = !drain_rotated;
 	}
 	else{
-		__android_log_print(ANDROID_LOG_ERROR,"snoop decoder","jvm not defined\n");
+		//file path refers to another file (btsnoop_hci.log moved to btsnoop_hci.log.last and recreated)
+		replaced = path_stat.st_ino != fd_stat.st_ino || path_stat.st_dev != fd_stat.st_dev;
 	}
-    
-    #endif // __ANDROID__
 
-	return 0;
+	bool truncated = fd_stat.st_size < index;
+
+	if (!truncated && state == PACKET_RECORD){
+
+		char header[16];
+
+		//file truncated and written again since last iteration
+		truncated = pread(stream_fd, header, 16, 0) != 16 || memcmp(header, stream_header, 16) != 0;
+	}
+
+	if (!replaced && !truncated){
+		return false;
+	}
+
+	if (replaced){
+
+		if (drain_rotated && !truncated){
+			//packets written to rotated file before new file was created
+			decode_streaming_file(stream_fd, index, false);
+		}
+		close(stream_fd);
+
+		stream_fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+	}
+
+	//bytes kept from previous file are no longer valid
+	block_reader.reset(-1, 0);
+
+	index = 0;
+	state = FILE_HEADER;
+
+	return true;
 }
 
 /**
  * @brief
- *      get the last <packet_number> packet index without doing any decoding
- * @return
- *      last <packet_number> packet index
+ *      decode packet records from byte source until end of stream / stop
  */
-int BtSnoopTask::get_last_n_packet_index(int packet_number) {
+void BtSnoopTask::stream_source() {
+
+	//source is not seekable : partial records are kept in block reader until completed
+	block_reader.reset(source);
 
-	int index = 0;
+	while (task_control && block_reader.available() < 16 && block_reader.fill() > 0);
 
-	ifstream fileStream(file_path.c_str());
+	if (task_control && block_reader.available() >= 16){
 
-	if (fileStream.is_open()) {
+		fileInfo = BtSnoopFileInfo(block_reader.data());
+		state = PACKET_RECORD;
 
-		fileStream.seekg(0,ios::beg);
+		block_reader.consume(16);
 
-		if (!fileStream.eof() && fileStream.tellg()!=-1) {
+		int packet_count = 0;
 
-			index = decode_streaming_file(&fileStream, 0, true);
+		decode_blocks(false, packet_count);
+	}
 
-			int check = index_table.size()-packet_number-1;
+	block_reader.reset(-1, 0);
+	task_control = false;
 
-			if (check > 0) {
-				return index_table[index_table.size()-packet_number-1];
-			}
-			return 0;
-		}
+	//source may be released by caller as soon as stream has ended
+	source = 0;
+}
+
+/**
+ * @brief
+ *      get the last <packet_number> packet index without doing any decoding
+ * @return
+ *      last <packet_number> packet index
+ */
+int64_t BtSnoopTask::get_last_n_packet_index(int packet_number) {
+
+	int fd = stream_fd;
+
+	if (fd == -1){
+		fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
 	}
-	else{
+
+	if (fd == -1){
 
 		#ifdef __ANDROID__
 		__android_log_print(ANDROID_LOG_ERROR,"snoop decoder","file could not be opened");
 		#else
 		cerr << "file could not be opened" << endl;
 		#endif // __ANDROID__
+		return 0;
+	}
+
+	int64_t index = 0;
+
+	if (index_file_enabled && read_file_header(fd)){
+
+		//records appended since last session are the only ones read
+		BtSnoopIndexFile index_file;
+		index_file.load(file_path + INDEX_FILE_EXTENSION, fd);
+		index_file.update(fd);
+
+		//index is a cache : if it cant be written file is indexed again next time
+		index_file.save();
+
+		packet_total = (int64_t)index_file.size();
+
+		//position after record (packet_total - packet_number - 1)
+		if (packet_total - (int64_t)packet_number - 1 > 0){
+			index = packet_number > 0 ? index_file.getOffset(packet_total - packet_number) : index_file.getIndexedEnd();
+		}
+	}
+	else{
+		//counting always starts from file header (task may already be decoding records)
+		state = FILE_HEADER;
+
+		//only end positions of the last packet_number + 1 records are kept during the scan,
+		//ring is bounded by the number of records the file can hold
+		struct stat file_stat;
+
+		int64_t max_records = 0;
+
+		if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 16){
+			max_records = (file_stat.st_size - 16) / 24;
+		}
+
+		int64_t ring_size = std::min((int64_t)(packet_number > 0 ? packet_number : 0), max_records) + 1;
+
+		tail_ring.assign((size_t)ring_size, 0);
+		tail_count = 0;
+
+		decode_streaming_file(fd, 0, true);
+
+		packet_total = (int64_t)tail_count;
+
+		int64_t last = packet_total - packet_number - 1;
+
+		//records appended during the scan may have overwritten a capped ring
+		if (last > 0 && last >= (int64_t)tail_count - ring_size) {
+			index = tail_ring[last % ring_size];
+		}
+		std::vector<int64_t>().swap(tail_ring);
 	}
 
+	if (fd != stream_fd){
+		close(fd);
+	}
 	return index;
 }
 
+/**
+ * @brief
+ *      read file header and start decoding packet records
+ * @param fd
+ *      file descriptor
+ * @return
+ *      success status
+ */
+bool BtSnoopTask::read_file_header(int fd) {
+
+	char file_header[16];
+
+	if (pread(fd, file_header, 16, 0) != 16){
+		return false;
+	}
+	fileInfo = BtSnoopFileInfo(file_header);
+	memcpy(stream_header, file_header, 16);
+
+	state=PACKET_RECORD;
+	return true;
+}
+
 /**
  * @brief
  *      decode full snoop file header / packet record data
- * @param fileStream
- *      file
+ * @param fd
+ *      file descriptor (only read with pread, file offset is not used)
  * @param current_position
  *      current position of file (initial is 0 / cant be -1)
- * @param fill_index_table
- * 		set to true if packet index table is filled each time a packet is decoded
+ * @param count_only
+ * 		set to true if packet records are only counted (end position of last records
+ * 		kept in tail ring) instead of being decoded
  * @return
  *      new position of file (to match with incoming changes)
  */
-int BtSnoopTask::decode_streaming_file(ifstream *fileStream,int current_position,bool fill_index_table) {
+int64_t BtSnoopTask::decode_streaming_file(int fd,int64_t current_position,bool count_only) {
 
 	int packet_count=0;
 
-	if (fill_index_table){
-		index_table.clear();
+	struct stat file_stat;
+
+	if (fstat(fd, &file_stat) == -1){
+		return current_position;
 	}
 
+	int64_t length = file_stat.st_size;
+
 	switch(state){
 
 		case FILE_HEADER:
 		{
-			char* file_header = new char[16];
-			fileStream->read(file_header, 16);
-			fileInfo = BtSnoopFileInfo(file_header);
-			delete[] file_header;
-
-			current_position = fileStream->tellg();
-			state=PACKET_RECORD;
+			if (length < 16 || !read_file_header(fd)){
+				return current_position;
+			}
+			current_position = 16;
 		}
 		case PACKET_RECORD:
 		{
-			fileStream->seekg (0, fileStream->end);
-			int length = fileStream->tellg();
-			fileStream->seekg(current_position,ios::beg);
+			if (current_position < length){
+
+				//incomplete record at the end of previous iteration is completed with appended bytes only
+				if (!count_only && block_reader.resume(fd, current_position, length)){
+					current_position = decode_blocks(false, packet_count);
+				}
+				else{
+					current_position = read_records(fd, current_position, length, count_only, packet_count, count_only);
+				}
+			}
+		}
+	}
+	return current_position;
+}
+
+/**
+ * @brief
+ *      read file by blocks and decode all complete packet records
+ * @param fd
+ *      file descriptor
+ * @param position
+ *      position of first packet record
+ * @param end
+ *      position where reading stops (-1 to read until end of file)
+ * @param count_only
+ * 		set to true if packet records are only counted (end position of last records
+ * 		kept in tail ring) instead of being decoded
+ * @param packet_count
+ *      number of counted packets (incremented for each record)
+ * @param bulk
+ *      whole file is read : asynchronous reads are used if enabled
+ * @return
+ *      position after last complete packet record
+ */
+int64_t BtSnoopTask::read_records(int fd,int64_t position,int64_t end,bool count_only,int &packet_count,bool bulk) {
+
+	block_reader.reset(fd, position, end, bulk && async_read);
+
+	return decode_blocks(count_only, packet_count);
+}
 
-			while ((fileStream->tellg() != -1) && (length != fileStream->tellg())) {
+/**
+ * @brief
+ *      decode all complete packet records read by block reader until end of data
+ * @param count_only
+ * 		set to true if packet records are only counted (end position of last records
+ * 		kept in tail ring) instead of being decoded
+ * @param packet_count
+ *      number of counted packets (incremented for each record)
+ * @return
+ *      position after last complete packet record
+ */
+int64_t BtSnoopTask::decode_blocks(bool count_only,int &packet_count) {
 
-				char * packet_header = new char[24];
+	size_t min_available = 0;
 
-				fileStream->read(packet_header, 24);
+	//data already buffered (file header read from a source) is decoded before next read
+	do {
 
-				if (fileStream->tellg()!=-1){
+		size_t consumed = decode_records(block_reader.data(), block_reader.available(), block_reader.position(), count_only, packet_count);
 
-					BtSnoopPacket packet(packet_header);
+		block_reader.consume(consumed);
 
-					char * packet_data = new char[packet.getincludedLength()];
+		min_available = 0;
 
-					fileStream->read(packet_data, packet.getincludedLength());
+		//record bigger than a block
+		if (block_reader.available() >= 24) {
+			min_available = 24 + (unsigned int)BtSnoopPacketView(block_reader.data(), block_reader.data() + 24).getincludedLength();
+		}
 
-					current_position = fileStream->tellg();
+	} while (block_reader.fill(min_available) > 0);
 
-					if (fill_index_table) {
-						index_table[packet_count] = current_position;
-						packet_count++;
-					}
-					else {
-						packet.decode_data(packet_data);
+	return block_reader.position();
+}
 
-						delete[] packet_data;
+/**
+ * @brief
+ *      decode all complete packet records in a buffer
+ * @param data
+ *      buffer starting with a packet record
+ * @param size
+ *      buffer size
+ * @param position
+ *      file position of buffer
+ * @param count_only
+ * 		set to true if packet records are only counted (end position of last records
+ * 		kept in tail ring) instead of being decoded
+ * @param packet_count
+ *      number of counted packets (incremented for each record)
+ * @return
+ *      number of bytes consumed (incomplete trailing record is not consumed)
+ */
+size_t BtSnoopTask::decode_records(const char * data,size_t size,int64_t position,bool count_only,int &packet_count) {
 
-						if (snoopListenerList!=0){
+	if (count_only) {
+		return index_records(data, size, position, packet_count);
+	}
 
-							for (unsigned int i = 0; i  < snoopListenerList->size();i++){
-								#ifdef __ANDROID__
-								snoopListenerList->at(i)->onSnoopPacketReceived(fileInfo,packet,jni_env);
-								#else
-								snoopListenerList->at(i)->onSnoopPacketReceived(fileInfo,packet);
-								#endif //__ANDROID__
-							}
-						}
+	if (column_store_enabled){
+		column_store.append(data, size);
+	}
 
-						packetDataRecords.push_back(packet);
-					}
-				}
-				delete[] packet_header;
-			}
+	size_t offset = 0;
+
+	while (size - offset >= 24) {
+
+		BtSnoopPacketView view(data + offset, data + offset + 24);
+
+		size_t record_size = 24 + (unsigned int)view.getincludedLength();
+
+		if (record_size > size - offset){
+			break;
+		}
+
+		//listeners read fields in place : packet is only built by listeners keeping it
+		batch.push_back(view);
+
+		if (batch.size() >= TASK_BATCH_MAX_SIZE){
+			notify_batch();
 		}
+
+		retain(view);
+
+		offset += record_size;
 	}
-	return current_position;
+
+	//views point into read buffer : delivered before buffer is refilled
+	notify_batch();
+
+	return offset;
+}
+
+/**
+ * @brief
+ *      count all complete packet records in a buffer and keep end position of last ones
+ *      in tail ring (record headers are decoded by batch)
+ * @param data
+ *      buffer starting with a packet record
+ * @param size
+ *      buffer size
+ * @param position
+ *      file position of buffer
+ * @param packet_count
+ *      number of counted packets (incremented for each record)
+ * @return
+ *      number of bytes consumed (incomplete trailing record is not consumed)
+ */
+size_t BtSnoopTask::index_records(const char * data,size_t size,int64_t position,int &packet_count) {
+
+	size_t offsets[TASK_INDEX_BATCH_SIZE];
+	uint32_t included_lengths[TASK_INDEX_BATCH_SIZE];
+
+	//only record sizes are needed
+	BtSnoopHeaderColumns columns;
+	columns.offsets = offsets;
+	columns.original_lengths = 0;
+	columns.included_lengths = included_lengths;
+	columns.flags = 0;
+	columns.cumulative_drops = 0;
+	columns.timestamps = 0;
+
+	size_t offset = 0;
+	size_t count = 0;
+
+	do {
+		size_t consumed = 0;
+
+		count = BtSnoopHeaderDecoder::decode(data + offset, size - offset, TASK_INDEX_BATCH_SIZE, columns, consumed);
+
+		for (size_t i = 0; i < count;i++){
+
+			int64_t end = position + offset + offsets[i] + 24 + included_lengths[i];
+
+			//only last records are kept when counting for a tail-N start
+			if (!tail_ring.empty()){
+				tail_ring[tail_count % tail_ring.size()] = end;
+			}
+			tail_count++;
+			packet_count++;
+		}
+		offset += consumed;
+
+	} while (count == TASK_INDEX_BATCH_SIZE);
+
+	return offset;
 }
 
 /**
@@ -397,83 +1101,265 @@ BtSnoopFileInfo BtSnoopTask::getFileInfo(){
  *      list of btsnoop decoded packets
  */
 std::vector<BtSnoopPacket> BtSnoopTask::getPacketDataRecords(){
-	return packetDataRecords;
+
+	if (packed_records_enabled){
+
+		std::vector<BtSnoopPacket> packets;
+		packets.reserve(packed_store.size());
+
+		for (size_t i = 0; i < packed_store.size();i++){
+			packets.push_back(packed_store.toPacket(i));
+		}
+		return packets;
+	}
+	return std::vector<BtSnoopPacket>(packetDataRecords.begin(), packetDataRecords.end());
 }
 
 /**
  * @brief
- *      decode full snoop file header / packet record data
+ *      get range over decoded packets without copy (records appended later are not
+ *      part of the range, its iterators remain valid)
+ * @return
+ *      range of retained packets
+ */
+BtSnoopRecordRange BtSnoopTask::getRecords() const{
+	return BtSnoopRecordRange(&packetDataRecords, 0, packetDataRecords.size());
+}
+
+/**
+ * @brief
+ *      get number of retained packets
+ * @return
+ */
+size_t BtSnoopTask::getRecordCount() const{
+	return packetDataRecords.size();
+}
+
+/**
+ * @brief
+ *      get a retained packet without copy
+ * @param index
+ *      packet index (< getRecordCount())
+ * @return
+ */
+const BtSnoopPacket & BtSnoopTask::getRecord(size_t index) const{
+	return packetDataRecords[index];
+}
+
+/**
+ * @brief
+ *      decode full snoop file header / packet record data. gzip and zstd compressed
+ *      files (detected from magic bytes) are decompressed in a dedicated thread
  * @return
  *      success status
  */
 bool BtSnoopTask::decode_file() {
 
-	packetDataRecords.clear();
+	clear_records();
+	init_listeners();
+
+	int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
 
-	ifstream fileStream(file_path.c_str());
+	if (fd == -1) {
+		return false;
+	}
 
-	if (fileStream.is_open()) {
+	char file_header[16];
 
-		switch(state){
+	if (pread(fd, file_header, 16, 0) != 16){
+		close(fd);
+		return false;
+	}
 
-			case FILE_HEADER:
-			{
-				char* file_header = new char[16];
+	int packet_count = 0;
 
-				fileStream.read(file_header, 16);
+	compression_type compression = BtSnoopDecompressSource::detect(file_header, 16);
 
-				fileInfo=BtSnoopFileInfo(file_header);
+	if (compression != COMPRESSION_NONE){
 
-				delete[] file_header;
+		//decompression thread feeds block reader
+		BtSnoopDecompressSource source;
 
-				if (fileStream.tellg()!=-1) {
-					state=PACKET_RECORD;
-				}
-				else{
-					return false;
-				}
-			}
-			case PACKET_RECORD:
-			{
-				while (fileStream.tellg()!=-1){
+		if (!source.open(fd, compression)){
+			close(fd);
+			return false;
+		}
 
-					char * packet_header = new char[24];
+		block_reader.reset(&source);
 
-					fileStream.read(packet_header, 24);
+		while (block_reader.available() < 16 && block_reader.fill() > 0);
 
-					if (fileStream.tellg()!=-1){
+		if (block_reader.available() < 16){
+			source.close();
+			close(fd);
+			return false;
+		}
 
-						BtSnoopPacket packet(packet_header);
+		fileInfo = BtSnoopFileInfo(block_reader.data());
+		state = PACKET_RECORD;
 
-						char * packet_data = new char[packet.getincludedLength()];
+		block_reader.consume(16);
 
-						fileStream.read(packet_data, packet.getincludedLength());
+		decode_blocks(false, packet_count);
 
-						packet.decode_data(packet_data);
+		//corrupted or truncated compressed file : decoded packets are only a part of it
+		bool success = !source.has_failed();
 
-						delete[] packet_data;
+		block_reader.reset(-1, 0);
+		source.close();
+		close(fd);
+		return success;
+	}
 
-						if (snoopListenerList!=0){
+	fileInfo = BtSnoopFileInfo(file_header);
+	state = PACKET_RECORD;
 
-							for (unsigned int i = 0; i  < snoopListenerList->size();i++){
-								#ifdef __ANDROID__
-								snoopListenerList->at(i)->onSnoopPacketReceived(fileInfo,packet,jni_env);
-								#else
-								snoopListenerList->at(i)->onSnoopPacketReceived(fileInfo,packet);
-								#endif //__ANDROID__
-							}
-						}
+	read_records(fd, 16, -1, false, packet_count, true);
 
-						packetDataRecords.push_back(packet);
-					}
-					delete[] packet_header;
-				}
-			}
+	close(fd);
+	return true;
+}
+
+/**
+ * @brief
+ *      decode only packet records with a timestamp in [begin, end[. Record offsets
+ *      and timestamps are indexed (sidecar index is used if enabled) and matching
+ *      records are found by binary search over block timestamp bounds, so that
+ *      records with non-monotonic timestamps are also found
+ * @param begin
+ *      first unix timestamp in microseconds
+ * @param end
+ *      unix timestamp in microseconds after last one
+ * @return
+ *      success status (compressed files are not supported)
+ */
+bool BtSnoopTask::decode_time_range(uint64_t begin,uint64_t end) {
+
+	clear_records();
+	init_listeners();
+
+	int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+
+	if (fd == -1) {
+		return false;
+	}
+
+	char file_header[16];
+
+	//index is built from raw record headers
+	if (pread(fd, file_header, 16, 0) != 16 || BtSnoopDecompressSource::detect(file_header, 16) != COMPRESSION_NONE){
+		close(fd);
+		return false;
+	}
+
+	fileInfo = BtSnoopFileInfo(file_header);
+	state = PACKET_RECORD;
+
+	struct stat file_stat;
+
+	//truncated file : records are indexed again (file is otherwise expected to only grow)
+	if (fstat(fd, &file_stat) == -1 || time_range_index.getIndexedEnd() > file_stat.st_size){
+		time_range_index = BtSnoopIndexFile();
+	}
+
+	//index not built yet (index is not copied with task)
+	if (time_range_index.getIndexedEnd() == 0){
+
+		time_range_bounds.clear();
+
+		if (index_file_enabled){
+			time_range_index.load(file_path + INDEX_FILE_EXTENSION, fd);
 		}
+	}
+
+	//only records appended since last call are indexed
+	if (time_range_index.update(fd) > 0 && index_file_enabled){
+		time_range_index.save();
+	}
+	time_range_bounds.update(time_range_index);
+
+	std::vector<std::pair<size_t,size_t> > ranges;
 
-		fileStream.close();
-		return true;
+	//index timestamps are btsnoop timestamps (end may be UINT64_MAX for an open range)
+	uint64_t offset = BtSnoopTimestamp::UNIX_OFFSET_MICROSECONDS;
+
+	time_range_bounds.query(time_range_index, begin + offset, end > UINT64_MAX - offset ? UINT64_MAX : end + offset, ranges);
+
+	int packet_count = 0;
+
+	for (size_t i = 0; i < ranges.size();i++){
+
+		int64_t start = time_range_index.getOffset(ranges[i].first);
+		int64_t stop = ranges[i].second < time_range_index.size() ? time_range_index.getOffset(ranges[i].second) : time_range_index.getIndexedEnd();
+
+		read_records(fd, start, stop, false, packet_count, false);
 	}
-	return false;
+	block_reader.reset(-1, 0);
+
+	close(fd);
+	return true;
 }
 
+/**
+ * @brief
+ *      decode full snoop file header / packet record data from a read-only memory
+ *      mapping of the file. Listeners receive packet views pointing directly into
+ *      the mapping (valid only during the callback) and no packet is kept in
+ *      packet data records list
+ * @return
+ *      success status
+ */
+bool BtSnoopTask::decode_file_mapped() {
+
+	clear_records();
+	init_listeners();
+
+	BtSnoopMappedFile mapped_file;
+
+	if (!mapped_file.open(file_path) || mapped_file.size() < 16) {
+		return false;
+	}
+
+	const char * data = mapped_file.data();
+	size_t size = mapped_file.size();
+
+	//compressed file content cant be used in place
+	if (BtSnoopDecompressSource::detect(data, size) != COMPRESSION_NONE) {
+		mapped_file.close();
+		return decode_file();
+	}
+
+	fileInfo = BtSnoopFileInfo(data);
+	state = PACKET_RECORD;
+
+	if (column_store_enabled){
+		column_store.append(data + 16, size - 16);
+	}
+
+	size_t offset = 16;
+
+	while (offset + 24 <= size) {
+
+		BtSnoopPacketView view(data + offset, data + offset + 24);
+
+		size_t record_size = 24 + (unsigned int)view.getincludedLength();
+
+		//incomplete trailing record
+		if (record_size > size - offset) {
+			break;
+		}
+
+		batch.push_back(view);
+
+		if (batch.size() >= TASK_BATCH_MAX_SIZE){
+			notify_batch();
+		}
+
+		offset += record_size;
+	}
+
+	//mapping is released when returning
+	notify_batch();
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooptimeindex.cpp
+
+	Timestamp range search over a packet record index : minimum / maximum
+	timestamp of each block of records are used to skip blocks, so that
+	non-monotonic timestamps (clock adjustments) are still found
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnooptimeindex.h"
+#include "algorithm"
+
+BtSnoopTimeIndex::BtSnoopTimeIndex(){
+	count = 0;
+}
+
+/**
+ * @brief
+ *      extend block timestamp bounds to records added to a record index (bounds
+ *      are rebuilt if index has less records than bounds cover)
+ * @param index
+ *      record index
+ */
+void BtSnoopTimeIndex::update(const BtSnoopIndexFile &index){
+
+	if (index.size() < count){
+		clear();
+	}
+
+	if (index.size() == count){
+		return;
+	}
+
+	//last block may have been built with less records
+	size_t first_block = count / TIME_INDEX_BLOCK_SIZE;
+
+	count = index.size();
+
+	size_t blocks = (count + TIME_INDEX_BLOCK_SIZE - 1) / TIME_INDEX_BLOCK_SIZE;
+
+	block_min.resize(blocks);
+	block_max.resize(blocks);
+	prefix_max.resize(blocks);
+	suffix_min.resize(blocks);
+
+	for (size_t block = first_block; block < blocks;block++){
+
+		size_t first = block * TIME_INDEX_BLOCK_SIZE;
+		size_t last = std::min(first + TIME_INDEX_BLOCK_SIZE, count);
+
+		uint64_t minimum = index.getTimestamp(first);
+		uint64_t maximum = minimum;
+
+		for (size_t i = first + 1; i < last;i++){
+			uint64_t timestamp = index.getTimestamp(i);
+			minimum = std::min(minimum, timestamp);
+			maximum = std::max(maximum, timestamp);
+		}
+		block_min[block] = minimum;
+		block_max[block] = maximum;
+		prefix_max[block] = block > 0 ? std::max(prefix_max[block - 1], maximum) : maximum;
+	}
+
+	//suffix minimum of previous blocks depends on new blocks
+	for (size_t block = blocks; block > 0;block--){
+
+		uint64_t minimum = block < blocks ? std::min(suffix_min[block], block_min[block - 1]) : block_min[block - 1];
+
+		if (block <= first_block && suffix_min[block - 1] == minimum){
+			break;
+		}
+		suffix_min[block - 1] = minimum;
+	}
+}
+
+/**
+ * @brief
+ *      discard block timestamp bounds
+ */
+void BtSnoopTimeIndex::clear(){
+	count = 0;
+	block_min.clear();
+	block_max.clear();
+	prefix_max.clear();
+	suffix_min.clear();
+}
+
+/**
+ * @brief
+ *      find records with a timestamp in [begin, end[
+ * @param index
+ *      record index (bounds must be up to date with update())
+ * @param begin
+ *      first btsnoop timestamp (microseconds since 01/01/0 AD)
+ * @param end
+ *      btsnoop timestamp after last one
+ * @param ranges
+ *      ranges of consecutive matching records [first record, last record + 1[ in
+ *      file order
+ */
+void BtSnoopTimeIndex::query(const BtSnoopIndexFile &index,uint64_t begin,uint64_t end,std::vector<std::pair<size_t,size_t> > &ranges) const{
+
+	ranges.clear();
+
+	if (begin >= end){
+		return;
+	}
+
+	//blocks before first block : all timestamps are lower than begin
+	size_t first_block = std::lower_bound(prefix_max.begin(), prefix_max.end(), begin) - prefix_max.begin();
+
+	//blocks from last block : all timestamps are greater than or equal to end
+	size_t last_block = std::lower_bound(suffix_min.begin(), suffix_min.end(), end) - suffix_min.begin();
+
+	for (size_t block = first_block; block < last_block;block++){
+
+		//block out of range (only happens with non-monotonic timestamps)
+		if (block_max[block] < begin || block_min[block] >= end){
+			continue;
+		}
+
+		size_t first = block * TIME_INDEX_BLOCK_SIZE;
+		size_t last = std::min(first + TIME_INDEX_BLOCK_SIZE, count);
+
+		for (size_t i = first; i < last;i++){
+
+			uint64_t timestamp = index.getTimestamp(i);
+
+			if (timestamp < begin || timestamp >= end){
+				continue;
+			}
+
+			if (!ranges.empty() && ranges.back().second == i){
+				ranges.back().second = i + 1;
+			}
+			else{
+				ranges.push_back(std::make_pair(i, i + 1));
+			}
+		}
+	}
+}
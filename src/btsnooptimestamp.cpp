@@ -0,0 +1,203 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooptimestamp.cpp
+
+	Convert btsnoop record timestamps (microseconds since 01/01/0 AD) without
+	any time zone / libc call : safe to use from several decoding threads
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnooptimestamp.h"
+#include "btsnoop/btsnoopendian.h"
+
+constexpr uint64_t BtSnoopTimestamp::UNIX_OFFSET_MICROSECONDS;
+
+/**
+ * @brief
+ *      decode btsnoop timestamp from a record header
+ * @param header
+ *      record header of size 24 (timestamp is the last 8 bytes, big endian)
+ * @return
+ */
+uint64_t BtSnoopTimestamp::decode(const char * header){
+
+	return btsnoop_read_be64(header + 16);
+}
+
+/**
+ * @brief
+ *      build timestamp converter
+ * @param format
+ *      output format
+ */
+BtSnoopTimestamp::BtSnoopTimestamp(timestamp_format format){
+	this->format = format;
+	origin = 0;
+	origin_set = false;
+}
+
+/**
+ * @brief
+ *      convert one btsnoop timestamp. In relative format, first converted
+ *      timestamp is the origin (result in microseconds)
+ * @param raw
+ *      btsnoop timestamp
+ * @return
+ *      converted timestamp
+ */
+int64_t BtSnoopTimestamp::convert(uint64_t raw){
+
+	switch(format){
+
+		case TIMESTAMP_RAW:
+			return raw;
+		case TIMESTAMP_UNIX_MICROSECONDS:
+			return toUnixMicroseconds(raw);
+		case TIMESTAMP_UNIX_NANOSECONDS:
+			return toUnixNanoseconds(raw);
+		case TIMESTAMP_RELATIVE:
+		{
+			if (!origin_set){
+				origin = raw;
+				origin_set = true;
+			}
+			return (int64_t)(raw - origin);
+		}
+	}
+	return raw;
+}
+
+/**
+ * @brief
+ *      convert an array of btsnoop timestamps
+ * @param raw
+ *      btsnoop timestamps
+ * @param output
+ *      converted timestamps (count values)
+ * @param count
+ *      number of timestamps
+ */
+void BtSnoopTimestamp::convert(const uint64_t * raw,int64_t * output,size_t count){
+
+	if (count == 0){
+		return;
+	}
+
+	//format is resolved once : loops below have no branch and can be vectorized
+	uint64_t offset = 0;
+	uint64_t scale = 1;
+
+	switch(format){
+
+		case TIMESTAMP_RAW:
+			break;
+		case TIMESTAMP_UNIX_MICROSECONDS:
+			offset = UNIX_OFFSET_MICROSECONDS;
+			break;
+		case TIMESTAMP_UNIX_NANOSECONDS:
+			offset = UNIX_OFFSET_MICROSECONDS;
+			scale = 1000;
+			break;
+		case TIMESTAMP_RELATIVE:
+		{
+			if (!origin_set){
+				origin = raw[0];
+				origin_set = true;
+			}
+			offset = origin;
+			break;
+		}
+	}
+
+	for (size_t i = 0; i < count;i++){
+		output[i] = (int64_t)((raw[i] - offset) * scale);
+	}
+}
+
+/**
+ * @brief
+ *      convert timestamps of a list of packet records
+ * @param records
+ *      decoded packet records
+ * @param output
+ *      converted timestamps (one per record)
+ */
+void BtSnoopTimestamp::convert(const std::vector<BtSnoopPacket> &records,std::vector<int64_t> &output){
+
+	std::vector<uint64_t> raw(records.size());
+
+	for (unsigned int i = 0; i < records.size();i++){
+		raw[i] = records[i].getTimestamp();
+	}
+
+	output.resize(records.size());
+
+	if (!raw.empty()){
+		convert(&raw[0], &output[0], raw.size());
+	}
+}
+
+/**
+ * @brief
+ *      convert timestamps of a range of retained packet records
+ * @param records
+ *      packet records
+ * @param output
+ *      converted timestamps (one per record)
+ */
+void BtSnoopTimestamp::convert(const BtSnoopRecordRange &records,std::vector<int64_t> &output){
+
+	std::vector<uint64_t> raw(records.size());
+
+	for (unsigned int i = 0; i < records.size();i++){
+		raw[i] = records[i].getTimestamp();
+	}
+
+	output.resize(records.size());
+
+	if (!raw.empty()){
+		convert(&raw[0], &output[0], raw.size());
+	}
+}
+
+/**
+ * @brief
+ *      forget origin of relative timestamps (next converted timestamp is the new origin)
+ */
+void BtSnoopTimestamp::reset(){
+	origin = 0;
+	origin_set = false;
+}
+
+/**
+ * @brief
+ *      get output format
+ * @return
+ */
+timestamp_format BtSnoopTimestamp::getFormat(){
+	return format;
+}
@@ -0,0 +1,444 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopuringreader.cpp
+
+	Sequential file reader keeping several io_uring reads in flight
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnoopuringreader.h"
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifdef BTSNOOP_IO_URING
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+static int uring_setup(unsigned entries, struct io_uring_params * params){
+	return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags){
+	return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+#endif // BTSNOOP_IO_URING
+
+BtSnoopUringReader::BtSnoopUringReader(){
+	fd = -1;
+	ring_fd = -1;
+	sq_ring = 0;
+	sq_ring_size = 0;
+	cq_ring = 0;
+	cq_ring_size = 0;
+	sqes = 0;
+	sqes_size = 0;
+	sq_tail = 0;
+	sq_mask = 0;
+	sq_array = 0;
+	cq_head = 0;
+	cq_tail = 0;
+	cq_mask = 0;
+	cqes = 0;
+	current_slot = 0;
+	inflight = 0;
+	submit_position = 0;
+	end_position = 0;
+	block_size = 0;
+	eof = false;
+}
+
+/**
+ * @brief
+ *      ring state is not copied : copy is a closed reader
+ */
+BtSnoopUringReader::BtSnoopUringReader(const BtSnoopUringReader&){
+	fd = -1;
+	ring_fd = -1;
+	sq_ring = 0;
+	sq_ring_size = 0;
+	cq_ring = 0;
+	cq_ring_size = 0;
+	sqes = 0;
+	sqes_size = 0;
+	sq_tail = 0;
+	sq_mask = 0;
+	sq_array = 0;
+	cq_head = 0;
+	cq_tail = 0;
+	cq_mask = 0;
+	cqes = 0;
+	current_slot = 0;
+	inflight = 0;
+	submit_position = 0;
+	end_position = 0;
+	block_size = 0;
+	eof = false;
+}
+
+BtSnoopUringReader& BtSnoopUringReader::operator=(const BtSnoopUringReader& other){
+	if (this != &other){
+		close();
+	}
+	return *this;
+}
+
+BtSnoopUringReader::~BtSnoopUringReader(){
+	close();
+}
+
+/**
+ * @brief
+ *      define if reader is opened
+ * @return
+ */
+bool BtSnoopUringReader::is_open() const{
+	return ring_fd != -1;
+}
+
+#ifdef BTSNOOP_IO_URING
+
+/**
+ * @brief
+ *      create io_uring instance and queue first reads
+ * @param fd
+ *      file descriptor
+ * @param position
+ *      position of first byte to read
+ * @param end
+ *      position where reading stops
+ * @param block_size
+ *      size of one read
+ * @return
+ *      false if io_uring is not available (not built in / not supported by kernel)
+ */
+bool BtSnoopUringReader::open(int fd,int64_t position,int64_t end,size_t block_size){
+
+	close();
+
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	ring_fd = uring_setup(URING_READER_DEPTH, &params);
+
+	if (ring_fd == -1){
+		return false;
+	}
+
+	sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP){
+		if (cq_ring_size > sq_ring_size){
+			sq_ring_size = cq_ring_size;
+		}
+		cq_ring_size = sq_ring_size;
+	}
+
+	sq_ring = mmap(0, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+
+	if (sq_ring == MAP_FAILED){
+		sq_ring = 0;
+		close();
+		return false;
+	}
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP){
+		cq_ring = sq_ring;
+	}
+	else{
+		cq_ring = mmap(0, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+
+		if (cq_ring == MAP_FAILED){
+			cq_ring = 0;
+			close();
+			return false;
+		}
+	}
+
+	sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	sqes = mmap(0, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+
+	if (sqes == MAP_FAILED){
+		sqes = 0;
+		close();
+		return false;
+	}
+
+	sq_tail = (unsigned *)((char *)sq_ring + params.sq_off.tail);
+	sq_mask = (unsigned *)((char *)sq_ring + params.sq_off.ring_mask);
+	sq_array = (unsigned *)((char *)sq_ring + params.sq_off.array);
+	cq_head = (unsigned *)((char *)cq_ring + params.cq_off.head);
+	cq_tail = (unsigned *)((char *)cq_ring + params.cq_off.tail);
+	cq_mask = (unsigned *)((char *)cq_ring + params.cq_off.ring_mask);
+	cqes = (char *)cq_ring + params.cq_off.cqes;
+
+	this->fd = fd;
+	this->block_size = block_size;
+	submit_position = position;
+	end_position = end;
+	current_slot = 0;
+	inflight = 0;
+	eof = false;
+
+	for (int i = 0; i < URING_READER_DEPTH;i++){
+		slots[i].pending = false;
+		slots[i].length = 0;
+		slots[i].result = 0;
+		slots[i].consumed = 0;
+		submit(i);
+	}
+
+	if (inflight > 0 && uring_enter(ring_fd, inflight, 0, 0) == -1){
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief
+ *      queue a read of next block in a slot
+ */
+void BtSnoopUringReader::submit(int slot){
+
+	read_slot &read = slots[slot];
+
+	read.consumed = 0;
+	read.result = 0;
+	read.length = 0;
+
+	if (eof || submit_position >= end_position){
+		return;
+	}
+
+	read.length = block_size;
+
+	if ((int64_t)read.length > end_position - submit_position){
+		read.length = end_position - submit_position;
+	}
+
+	if (read.buffer.size() < block_size){
+		read.buffer.resize(block_size);
+	}
+
+	read.position = submit_position;
+	read.iov.iov_base = &read.buffer[0];
+	read.iov.iov_len = read.length;
+	read.pending = true;
+
+	submit_position += read.length;
+
+	unsigned tail = *sq_tail;
+	unsigned index = tail & *sq_mask;
+
+	struct io_uring_sqe * sqe = &((struct io_uring_sqe *)sqes)[index];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READV;
+	sqe->fd = fd;
+	sqe->off = read.position;
+	sqe->addr = (unsigned long)&read.iov;
+	sqe->len = 1;
+	sqe->user_data = slot;
+
+	sq_array[index] = index;
+
+	__atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	inflight++;
+}
+
+/**
+ * @brief
+ *      wait for at least one completion and dispatch all completions to their slot
+ * @return
+ *      success status
+ */
+bool BtSnoopUringReader::reap(){
+
+	unsigned head = *cq_head;
+
+	while (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)){
+
+		if (uring_enter(ring_fd, 0, 1, IORING_ENTER_GETEVENTS) == -1 && errno != EINTR){
+			return false;
+		}
+	}
+
+	while (head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)){
+
+		struct io_uring_cqe * cqe = &((struct io_uring_cqe *)cqes)[head & *cq_mask];
+
+		read_slot &read = slots[cqe->user_data];
+		read.result = cqe->res;
+		read.pending = false;
+		inflight--;
+
+		head++;
+	}
+
+	__atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+/**
+ * @brief
+ *      read next bytes of file (sequential)
+ * @param data
+ *      destination buffer
+ * @param size
+ *      maximum number of bytes to read
+ * @return
+ *      number of bytes read, 0 on end of file, -1 on error
+ */
+ssize_t BtSnoopUringReader::read(char * data,size_t size){
+
+	if (ring_fd == -1){
+		return -1;
+	}
+
+	size_t total = 0;
+
+	while (total < size){
+
+		read_slot &read = slots[current_slot];
+
+		if (read.length == 0){
+			//nothing queued anymore : end of file
+			break;
+		}
+
+		while (read.pending){
+			if (!reap()){
+				return -1;
+			}
+		}
+
+		if (read.result < 0){
+			errno = -read.result;
+			return total > 0 ? (ssize_t)total : -1;
+		}
+
+		size_t remaining = read.result - read.consumed;
+		size_t count = (size - total < remaining) ? size - total : remaining;
+
+		memcpy(data + total, &read.buffer[read.consumed], count);
+
+		read.consumed += count;
+		total += count;
+
+		if (read.consumed == (size_t)read.result){
+
+			//short read : file ended before end position, reads queued after it are not valid
+			if ((size_t)read.result < read.length){
+				eof = true;
+			}
+
+			submit(current_slot);
+
+			if (slots[current_slot].pending && uring_enter(ring_fd, 1, 0, 0) == -1){
+				return total > 0 ? (ssize_t)total : -1;
+			}
+
+			current_slot = (current_slot + 1) % URING_READER_DEPTH;
+
+			if (eof){
+				break;
+			}
+		}
+	}
+
+	return total;
+}
+
+/**
+ * @brief
+ *      wait for pending reads and release io_uring instance
+ */
+void BtSnoopUringReader::close(){
+
+	if (ring_fd != -1){
+
+		//buffers must not be released while kernel may still write in them
+		while (inflight > 0 && cq_tail != 0){
+			if (!reap()){
+				break;
+			}
+		}
+
+		if (sqes != 0){
+			munmap(sqes, sqes_size);
+		}
+		if (cq_ring != 0 && cq_ring != sq_ring){
+			munmap(cq_ring, cq_ring_size);
+		}
+		if (sq_ring != 0){
+			munmap(sq_ring, sq_ring_size);
+		}
+		::close(ring_fd);
+	}
+
+	ring_fd = -1;
+	sq_ring = 0;
+	cq_ring = 0;
+	sqes = 0;
+	sq_tail = 0;
+	cq_tail = 0;
+	inflight = 0;
+	fd = -1;
+}
+
+#else
+
+/**
+ * @brief
+ *      io_uring support not built in
+ */
+bool BtSnoopUringReader::open(int /*fd*/,int64_t /*position*/,int64_t /*end*/,size_t /*block_size*/){
+	return false;
+}
+
+void BtSnoopUringReader::close(){
+}
+
+ssize_t BtSnoopUringReader::read(char * /*data*/,size_t /*size*/){
+	return -1;
+}
+
+void BtSnoopUringReader::submit(int /*slot*/){
+}
+
+bool BtSnoopUringReader::reap(){
+	return false;
+}
+
+#endif // BTSNOOP_IO_URING
@@ -0,0 +1,206 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopheaderdecodertest.cpp
+
+	Check that BtSnoopHeaderDecoder::decode (SIMD when supported) and
+	decode_scalar give identical columns for generated packet records with
+	varied fields, truncated trailing records and record count limits
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnoopheaderdecoder.h"
+#include "btsnoop/btsnoopendian.h"
+#include "vector"
+#include <stdio.h>
+#include <string.h>
+
+//number of generated packet records
+#define TEST_RECORD_COUNT 1000
+
+/**
+ * @brief
+ *      decoded columns of one decoding path
+ */
+struct DecodedColumns{
+
+	std::vector<size_t> offsets;
+
+	std::vector<uint32_t> original_lengths;
+
+	std::vector<uint32_t> included_lengths;
+
+	std::vector<uint8_t> flags;
+
+	std::vector<uint32_t> cumulative_drops;
+
+	std::vector<uint64_t> timestamps;
+
+	size_t count;
+
+	size_t consumed;
+};
+
+/**
+ * @brief
+ *      pseudo random generator (same records on every run)
+ */
+static uint32_t next_random(uint32_t &state){
+	state = state * 1103515245 + 12345;
+	return state >> 8;
+}
+
+/**
+ * @brief
+ *      decode a buffer with SIMD (when supported) or scalar path
+ */
+static void decode(const char * data,size_t size,size_t max_count,bool scalar,DecodedColumns &decoded){
+
+	//columns are filled with a marker to detect values written past decoded count
+	decoded.offsets.assign(max_count + 1, 0xA5);
+	decoded.original_lengths.assign(max_count + 1, 0xA5);
+	decoded.included_lengths.assign(max_count + 1, 0xA5);
+	decoded.flags.assign(max_count + 1, 0xA5);
+	decoded.cumulative_drops.assign(max_count + 1, 0xA5);
+	decoded.timestamps.assign(max_count + 1, 0xA5);
+
+	BtSnoopHeaderColumns columns;
+	columns.offsets = &decoded.offsets[0];
+	columns.original_lengths = &decoded.original_lengths[0];
+	columns.included_lengths = &decoded.included_lengths[0];
+	columns.flags = &decoded.flags[0];
+	columns.cumulative_drops = &decoded.cumulative_drops[0];
+	columns.timestamps = &decoded.timestamps[0];
+
+	decoded.consumed = 0;
+
+	if (scalar){
+		decoded.count = BtSnoopHeaderDecoder::decode_scalar(data, size, max_count, columns, decoded.consumed);
+	}
+	else{
+		decoded.count = BtSnoopHeaderDecoder::decode(data, size, max_count, columns, decoded.consumed);
+	}
+}
+
+/**
+ * @brief
+ *      decode with both paths and compare all columns
+ * @return
+ *      true if both paths give identical results
+ */
+static bool check_decode(const char * data,size_t size,size_t max_count,size_t expected_count){
+
+	DecodedColumns simd;
+	DecodedColumns scalar;
+
+	decode(data, size, max_count, false, simd);
+	decode(data, size, max_count, true, scalar);
+
+	bool success = simd.count == expected_count &&
+		simd.count == scalar.count &&
+		simd.consumed == scalar.consumed &&
+		simd.offsets == scalar.offsets &&
+		simd.original_lengths == scalar.original_lengths &&
+		simd.included_lengths == scalar.included_lengths &&
+		simd.flags == scalar.flags &&
+		simd.cumulative_drops == scalar.cumulative_drops &&
+		simd.timestamps == scalar.timestamps;
+
+	if (!success){
+		printf("size %d max count %d : %d / %d records, %d / %d bytes (expected %d records)\n",
+			(int)size, (int)max_count, (int)simd.count, (int)scalar.count,
+			(int)simd.consumed, (int)scalar.consumed, (int)expected_count);
+	}
+	return success;
+}
+
+int main(int argc, char *argv[]){
+
+	std::vector<char> buffer;
+	std::vector<size_t> record_ends;
+
+	uint32_t state = 1;
+
+	for (size_t i = 0; i < TEST_RECORD_COUNT;i++){
+
+		//mostly short records, some empty / bigger than a SIMD batch of headers
+		uint32_t included_length = next_random(state) % 8 == 0 ? next_random(state) % 2000 : next_random(state) % 64;
+
+		if (i % 97 == 0){
+			included_length = 0;
+		}
+
+		char header[24];
+		btsnoop_write_be32(header, included_length + next_random(state) % 3);
+		btsnoop_write_be32(header + 4, included_length);
+		btsnoop_write_be32(header + 8, next_random(state));
+		btsnoop_write_be32(header + 12, next_random(state) % 4 == 0 ? next_random(state) : 0);
+		btsnoop_write_be64(header + 16, ((uint64_t)next_random(state) << 32) | next_random(state));
+
+		buffer.insert(buffer.end(), header, header + 24);
+
+		for (uint32_t j = 0; j < included_length;j++){
+			buffer.push_back((char)next_random(state));
+		}
+		record_ends.push_back(buffer.size());
+	}
+
+	//truncated trailing record : complete header, incomplete payload
+	char header[24];
+	memset(header, 0x5A, 24);
+	btsnoop_write_be32(header + 4, 100);
+	buffer.insert(buffer.end(), header, header + 24);
+	buffer.insert(buffer.end(), 50, 0);
+
+	bool success = true;
+
+	success = check_decode(&buffer[0], buffer.size(), TEST_RECORD_COUNT + 1, TEST_RECORD_COUNT) && success;
+
+	//count limits not aligned with SIMD batches
+	for (size_t max_count = 1; max_count < 20;max_count++){
+		success = check_decode(&buffer[0], buffer.size(), max_count, max_count) && success;
+	}
+
+	//buffer ending inside a record header / payload
+	for (size_t i = 0; i < 40;i++){
+
+		size_t end = record_ends[i * 7] + (i * 13) % 30;
+		size_t expected = i * 7 + 1;
+
+		if (expected < record_ends.size() && end >= record_ends[expected]){
+			continue;
+		}
+		success = check_decode(&buffer[0], end, TEST_RECORD_COUNT, expected) && success;
+	}
+
+	//no complete record
+	success = check_decode(&buffer[0], 23, TEST_RECORD_COUNT, 0) && success;
+
+	printf("header decoder test %s (simd %s)\n", success ? "passed" : "failed",
+		BtSnoopHeaderDecoder::is_simd_supported() ? "used" : "not supported");
+
+	return success ? 0 : 1;
+}
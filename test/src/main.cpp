@@ -41,6 +41,7 @@
 #include <signal.h>
 #include "cstdlib"
 #include "btsnoop/btsnooptask.h"
+#include "btsnoop/btsnoopstreamsource.h"
 
 using namespace std;
 
@@ -52,7 +53,7 @@ void catch_signint(int sig){
 int main(int argc, char *argv[])
 {
 	if (argc <= 1){
-		cerr << "you must provide btsnoop file path " << endl;
+		cerr << "you must provide btsnoop file path (- for standard input)" << endl;
 		return -1;
 	}
 
@@ -73,12 +74,14 @@ int main(int argc, char *argv[])
 
 	decoder.getFileInfo().printInfo();
 
-	cout << decoder.getPacketDataRecords().size() << endl;
+	cout << decoder.getRecordCount() << endl;
 	*/
 
 	/*
-	for (int i = 0; i  < decoder.getPacketDataRecords().size();i++){
-		decoder.getPacketDataRecords()[i].printInfo();
+	BtSnoopRecordRange records = decoder.getRecords();
+
+	for (BtSnoopRecordRange::const_iterator it = records.begin(); it != records.end();++it){
+		it->printInfo();
 	}
 	*/
 
@@ -88,8 +91,18 @@ int main(int argc, char *argv[])
 
 	parser.addSnoopListener(&monitor);
 
-	//parse streaming file
-	bool success = parser.decode_streaming_file(recordFile,1500);
+	BtSnoopStreamSource input;
+
+	bool success = false;
+
+	if (recordFile == "-"){
+		//parse btsnoop data written on standard input
+		success = input.open_stdin() && parser.decode_streaming_source(&input);
+	}
+	else{
+		//parse streaming file
+		success = parser.decode_streaming_file(recordFile,1500);
+	}
 
 	if (!success)
 		cerr << "file reading error occured" << endl;
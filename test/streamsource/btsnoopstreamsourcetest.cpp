@@ -0,0 +1,231 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnoopstreamsourcetest.cpp
+
+	Decode a generated capture written to a 127.0.0.1 TCP connection in small
+	writes (file header, record headers and payloads split across writes) and
+	check decoded packets against written ones
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnoopparser.h"
+#include "btsnoop/btsnoopstreamsource.h"
+#include "btsnoop/btsnoopendian.h"
+#include "vector"
+#include "algorithm"
+#include "pthread.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+//number of generated packet records
+#define TEST_RECORD_COUNT 2000
+
+//maximum size of one write to the socket
+#define TEST_MAX_WRITE_SIZE 37
+
+/**
+ * @brief
+ *      generated capture and connected socket of the writer thread
+ */
+struct StreamWriter{
+
+	std::vector<char> capture;
+
+	int socket_fd;
+};
+
+/**
+ * @brief
+ *      record listener keeping a copy of each decoded packet
+ */
+class BtSnoopRecordCollector : public IBtSnoopRecordListener
+{
+
+public:
+
+	void onSnoopPacket(const BtSnoopFileInfo &fileInfo,const BtSnoopPacketView &record){
+		packets.push_back(record.toPacket());
+	}
+
+	std::vector<BtSnoopPacket> packets;
+};
+
+/**
+ * @brief
+ *      write capture in small writes of varying size, then close connection
+ */
+static void *write_capture(void *context){
+
+	StreamWriter * writer = (StreamWriter *)context;
+
+	size_t offset = 0;
+	size_t write_size = 1;
+
+	while (offset < writer->capture.size()){
+
+		size_t size = std::min(write_size, writer->capture.size() - offset);
+
+		ssize_t written = write(writer->socket_fd, &writer->capture[offset], size);
+
+		if (written <= 0){
+			break;
+		}
+		offset += written;
+		write_size = write_size % TEST_MAX_WRITE_SIZE + 1;
+
+		//let reader wake up on partial records
+		if (offset % 7 == 0){
+			usleep(10);
+		}
+	}
+	close(writer->socket_fd);
+
+	return 0;
+}
+
+/**
+ * @brief
+ *      build a capture with varied payload sizes
+ * @param capture
+ *      btsnoop file content
+ * @param payloads
+ *      payload of each record
+ */
+static void build_capture(std::vector<char> &capture,std::vector<std::vector<char> > &payloads){
+
+	char file_header[16] = {'b','t','s','n','o','o','p',0};
+	btsnoop_write_be32(file_header + 8, 1);
+	btsnoop_write_be32(file_header + 12, 1002);
+	capture.insert(capture.end(), file_header, file_header + 16);
+
+	for (size_t i = 0; i < TEST_RECORD_COUNT;i++){
+
+		uint32_t length = (i * 37) % (i % 10 == 0 ? 700 : 70);
+
+		std::vector<char> payload(length);
+
+		for (uint32_t j = 0; j < length;j++){
+			payload[j] = (char)(i * 31 + j);
+		}
+
+		char header[24];
+		btsnoop_write_be32(header, length);
+		btsnoop_write_be32(header + 4, length);
+		btsnoop_write_be32(header + 8, i % 4);
+		btsnoop_write_be32(header + 12, 0);
+		btsnoop_write_be64(header + 16, 0x00E03AB44A676000ULL + i * 1000);
+
+		capture.insert(capture.end(), header, header + 24);
+		capture.insert(capture.end(), payload.begin(), payload.end());
+		payloads.push_back(payload);
+	}
+}
+
+int main(int argc, char *argv[]){
+
+	StreamWriter writer;
+	std::vector<std::vector<char> > payloads;
+
+	build_capture(writer.capture, payloads);
+
+	//loopback server on a free port
+	int server_fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+
+	socklen_t address_size = sizeof(address);
+
+	if (server_fd == -1 ||
+		bind(server_fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+		listen(server_fd, 1) != 0 ||
+		getsockname(server_fd, (struct sockaddr *)&address, &address_size) != 0){
+		printf("cant create loopback server\n");
+		return 1;
+	}
+
+	BtSnoopStreamSource source;
+
+	//connection is queued by listen() until accepted
+	if (!source.connect_tcp("127.0.0.1", ntohs(address.sin_port))){
+		printf("cant connect to loopback server\n");
+		return 1;
+	}
+
+	writer.socket_fd = accept(server_fd, 0, 0);
+	close(server_fd);
+
+	if (writer.socket_fd == -1){
+		printf("cant accept loopback connection\n");
+		return 1;
+	}
+
+	BtSnoopRecordCollector collector;
+
+	BtSnoopParser parser;
+	parser.set_retention_policy(RETENTION_NONE, 0);
+	parser.addSnoopListener(&collector);
+
+	pthread_t writer_thread;
+
+	if (!parser.decode_streaming_source(&source) || pthread_create(&writer_thread, NULL, &write_capture, &writer) != 0){
+		printf("cant start decoding\n");
+		return 1;
+	}
+
+	//decoding ends when writer closes connection
+	parser.join();
+	pthread_join(writer_thread, NULL);
+
+	bool success = collector.packets.size() == payloads.size();
+
+	for (size_t i = 0; success && i < payloads.size();i++){
+
+		const BtSnoopPacket &packet = collector.packets[i];
+
+		success = packet.getPacketData() == payloads[i] &&
+			packet.getTimestamp() == 0x00E03AB44A676000ULL + i * 1000 &&
+			packet.is_packet_received() == ((i & 1) != 0) &&
+			packet.is_command_event() == ((i & 2) != 0);
+
+		if (!success){
+			printf("packet %d differs from written packet\n", (int)i);
+		}
+	}
+
+	printf("stream source test %s (%d packets decoded, %d written)\n", success ? "passed" : "failed",
+		(int)collector.packets.size(), (int)payloads.size());
+
+	return success ? 0 : 1;
+}
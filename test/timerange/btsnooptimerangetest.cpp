@@ -0,0 +1,171 @@
+/************************************************************************************
+ * The MIT License (MIT)                                                            *
+ *                                                                                  *
+ * Copyright (c) 2016 Bertrand Martel                                               *
+ *                                                                                  * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     * 
+ * of this software and associated documentation files (the "Software"), to deal    * 
+ * in the Software without restriction, including without limitation the rights     * 
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        * 
+ * copies of the Software, and to permit persons to whom the Software is            * 
+ * furnished to do so, subject to the following conditions:                         * 
+ *                                                                                  * 
+ * The above copyright notice and this permission notice shall be included in       * 
+ * all copies or substantial portions of the Software.                              * 
+ *                                                                                  * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR       * 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,         * 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      * 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           * 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,    * 
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN        * 
+ * THE SOFTWARE.                                                                    * 
+ ************************************************************************************/
+/**
+	btsnooptimerangetest.cpp
+
+	Check BtSnoopTask::decode_time_range against a full scan of generated
+	captures with backward clock steps (within and across index blocks) and
+	with records appended between two queries
+
+	@author Bertrand Martel
+	@version 0.1
+*/
+
+#include "btsnoop/btsnooptask.h"
+#include "btsnoop/btsnoopendian.h"
+#include "btsnoop/btsnooptimestamp.h"
+#include "vector"
+#include "string"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+//unix time of first generated record (microseconds)
+#define TEST_START_TIME 1500000000000000ULL
+
+//time between two generated records (microseconds)
+#define TEST_RECORD_INTERVAL 1000
+
+/**
+ * @brief
+ *      append packet records to a btsnoop file (header is written if file is empty)
+ * @param file
+ *      btsnoop file
+ * @param timestamps
+ *      unix timestamps of records in microseconds
+ */
+static void write_records(FILE * file,const std::vector<uint64_t> &timestamps){
+
+	if (ftell(file) == 0){
+		char file_header[16] = {'b','t','s','n','o','o','p',0};
+		btsnoop_write_be32(file_header + 8, 1);
+		btsnoop_write_be32(file_header + 12, 1002);
+		fwrite(file_header, 1, 16, file);
+	}
+
+	for (size_t i = 0; i < timestamps.size();i++){
+
+		char record[28] = {0};
+		btsnoop_write_be32(record, 4);
+		btsnoop_write_be32(record + 4, 4);
+		btsnoop_write_be32(record + 8, i % 2);
+		btsnoop_write_be64(record + 16, timestamps[i] + BtSnoopTimestamp::UNIX_OFFSET_MICROSECONDS);
+		btsnoop_write_be32(record + 24, (uint32_t)i);
+		fwrite(record, 1, 28, file);
+	}
+	fflush(file);
+}
+
+/**
+ * @brief
+ *      decode a time range and compare decoded packets with a scan of all timestamps
+ * @return
+ *      true if same packets are decoded in file order
+ */
+static bool check_range(BtSnoopTask &task,const std::vector<uint64_t> &timestamps,uint64_t begin,uint64_t end){
+
+	std::vector<uint64_t> expected;
+
+	for (size_t i = 0; i < timestamps.size();i++){
+		if (timestamps[i] >= begin && timestamps[i] < end){
+			expected.push_back(timestamps[i]);
+		}
+	}
+
+	bool success = task.decode_time_range(begin, end);
+
+	std::vector<BtSnoopPacket> packets = task.getPacketDataRecords();
+
+	success = success && packets.size() == expected.size();
+
+	for (size_t i = 0; success && i < packets.size();i++){
+		success = packets[i].getUnixTimestampMicroseconds() == expected[i];
+	}
+
+	if (!success){
+		printf("range [%llu, %llu[ : %d packets expected, %d decoded\n",
+			(unsigned long long)(begin - TEST_START_TIME), (unsigned long long)(end - TEST_START_TIME),
+			(int)expected.size(), (int)packets.size());
+	}
+	return success;
+}
+
+int main(int argc, char *argv[]){
+
+	char file_path[] = "/tmp/btsnooptimerangeXXXXXX";
+	int fd = mkstemp(file_path);
+
+	if (fd == -1){
+		printf("cant create test file\n");
+		return 1;
+	}
+
+	FILE * file = fdopen(fd, "wb");
+
+	std::vector<uint64_t> timestamps;
+
+	//block 1 : clock steps back 200ms at record 356, records 356 to 500 are before
+	//records 301 to 355
+	for (size_t i = 0; i < 3 * TIME_INDEX_BLOCK_SIZE;i++){
+		uint64_t timestamp = TEST_START_TIME + i * TEST_RECORD_INTERVAL;
+		timestamps.push_back(i < 356 ? timestamp : timestamp - 200 * TEST_RECORD_INTERVAL);
+	}
+	write_records(file, timestamps);
+
+	BtSnoopTask task(file_path);
+
+	bool success = true;
+
+	//begin inside the block with the backward step, before and after the step
+	success = check_range(task, timestamps, TEST_START_TIME + 300 * TEST_RECORD_INTERVAL + 500, TEST_START_TIME + 400 * TEST_RECORD_INTERVAL) && success;
+	success = check_range(task, timestamps, TEST_START_TIME + 200 * TEST_RECORD_INTERVAL, TEST_START_TIME + 320 * TEST_RECORD_INTERVAL) && success;
+	success = check_range(task, timestamps, TEST_START_TIME + 355 * TEST_RECORD_INTERVAL, TEST_START_TIME + 356 * TEST_RECORD_INTERVAL) && success;
+	success = check_range(task, timestamps, 0, UINT64_MAX) && success;
+
+	//appended records : last (partial) block and a new block step back before
+	//first blocks
+	std::vector<uint64_t> appended;
+
+	for (size_t i = 0; i < TIME_INDEX_BLOCK_SIZE + 10;i++){
+		appended.push_back(TEST_START_TIME + (250 + i) * TEST_RECORD_INTERVAL + 250);
+	}
+	write_records(file, appended);
+	timestamps.insert(timestamps.end(), appended.begin(), appended.end());
+
+	success = check_range(task, timestamps, TEST_START_TIME + 300 * TEST_RECORD_INTERVAL + 500, TEST_START_TIME + 400 * TEST_RECORD_INTERVAL) && success;
+	success = check_range(task, timestamps, TEST_START_TIME + 600 * TEST_RECORD_INTERVAL, TEST_START_TIME + 800 * TEST_RECORD_INTERVAL) && success;
+	success = check_range(task, timestamps, 0, TEST_START_TIME + 10 * TEST_RECORD_INTERVAL) && success;
+
+	//index is not copied with task
+	BtSnoopTask copy;
+	copy = task;
+	success = check_range(copy, timestamps, TEST_START_TIME + 256 * TEST_RECORD_INTERVAL, TEST_START_TIME + 512 * TEST_RECORD_INTERVAL) && success;
+
+	fclose(file);
+	unlink(file_path);
+
+	printf("time range test %s\n", success ? "passed" : "failed");
+
+	return success ? 0 : 1;
+}